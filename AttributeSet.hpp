@@ -0,0 +1,53 @@
+#ifndef _ATTRIBUTE_SET_HPP_
+#define _ATTRIBUTE_SET_HPP_
+
+#include <cstdint>
+#include <vector>
+
+
+/**
+    \brief Set of attribute bits of a section.
+    First 64 attributes of a config are kept inline, so usual sections need no allocation.
+*/
+class AttributeSet final
+{
+    uint64_t _first_word {0u};
+
+    // Words past the first one
+    std::vector<uint64_t> _words;
+
+public:
+    void set(const uint32_t bit)
+    {
+        if (bit < 64u)
+        {
+            _first_word |= (1ull << bit);
+            return;
+        }
+
+        const size_t word = (bit / 64u) - 1u;
+
+        if (word >= _words.size())
+            _words.resize(word + 1u, 0u);
+
+        _words[word] |= (1ull << (bit % 64u));
+    }
+
+    const bool test(const uint32_t bit) const noexcept
+    {
+        if (bit < 64u)
+            return (_first_word & (1ull << bit)) != 0u;
+
+        const size_t word = (bit / 64u) - 1u;
+
+        return (word < _words.size()) && ((_words[word] & (1ull << (bit % 64u))) != 0u);
+    }
+
+    void clear() noexcept
+    {
+        _first_word = 0u;
+        _words.clear();
+    }
+};
+
+#endif
@@ -1,7 +1,15 @@
 #include "CFGParser.hpp"
+#include "StructuralScanner.hpp"
 #include <iostream>
 #include <fstream>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <iterator>
 
 static constexpr std::array<char, 63u> allowed_characters
 {
@@ -19,6 +27,636 @@ inline constexpr bool isCharacterValid(const char character)
         character) == allowed_characters.cend();
 }
 
+/**
+    \brief Parsed token. Stays a view into the source while its characters are contiguous,
+    spills into own buffer once something is skipped in between or unescaped.
+*/
+class Token final
+{
+    std::string_view _view {};
+    std::string _buffer {};
+    bool _owned {false};
+
+public:
+    /**
+        \brief Appends source characters. Run must point into the parsed buffer.
+    */
+    inline Token& operator+=(const std::string_view run)
+    {
+        if (_owned)
+        {
+            _buffer += run;
+        }
+        else if (_view.empty())
+        {
+            _view = run;
+        }
+        else if (_view.data() + _view.size() == run.data())
+        {
+            _view = std::string_view(_view.data(), _view.size() + run.size());
+        }
+        else
+        {
+            this->spill();
+            _buffer += run;
+        }
+
+        return *this;
+    }
+
+    /**
+        \brief Appends character which does not exist in the source as is.
+    */
+    inline void push_back(const char character)
+    {
+        if (!_owned)
+            this->spill();
+
+        _buffer += character;
+    }
+
+    inline void clear() noexcept
+    {
+        _view = {};
+        _buffer.clear();
+        _owned = false;
+    }
+
+    inline const bool empty() const noexcept { return _owned ? _buffer.empty() : _view.empty(); }
+    inline const bool owned() const noexcept { return _owned; }
+    inline std::string_view view() const noexcept { return _owned ? std::string_view(_buffer) : _view; }
+    inline std::string str() const { return std::string(this->view()); }
+
+private:
+    inline void spill()
+    {
+        _buffer.assign(_view.data(), _view.size());
+        _owned = true;
+    }
+};
+
+enum class ParseAction : uint8_t
+{
+    NEW_LINE = 0u,
+    SECTION,
+    INHERITANCE,
+    ATTRIBUTE,
+    KEY,
+    VALUE,
+    VALUE_ARRAY,
+    STRING_VALUE,
+    COMMENT,
+    MULTILINE_COMMENT,
+    PREPROCESSOR,
+    INCLUDE,
+    ERROR
+};
+
+/**
+    \brief Character classes of the grammar, everything else is a literal.
+*/
+enum class CharacterClass : uint8_t
+{
+    LITERAL = 0u,
+    COMMENT,
+    MULTILINE_COMMENT,
+    SPACE,
+    ESCAPE,
+    QUOTE,
+    PREPROCESSOR,
+    NEW_LINE,
+    INCLUDE_BEGIN,
+    INCLUDE_END,
+    SECTION_BEGIN,
+    SECTION_END,
+    ENUMERATION,
+    INHERITANCE,
+    ASSIGNMENT,
+    COUNT
+};
+
+/**
+    \brief What tokenizer does with a character in a given state.
+*/
+enum class TokenOperation : uint8_t
+{
+    NONE = 0u,
+    ERROR,
+    APPEND_CHARACTER,
+    SKIP_RUN,
+    START_KEY,
+    APPEND_PREPROCESSOR,
+    APPEND_INCLUDE,
+    APPEND_SECTION,
+    APPEND_INHERITANCE,
+    APPEND_ATTRIBUTE,
+    APPEND_KEY,
+    APPEND_VALUE,
+    START_COMMENT,
+    START_MULTILINE_COMMENT,
+    END_MULTILINE_COMMENT,
+    CHECK_SPACE,
+    PREPROCESSOR_SPACE,
+    ESCAPE,
+    START_STRING,
+    END_STRING,
+    START_PREPROCESSOR,
+    NEW_LINE,
+    NEW_LINE_INHERITANCE,
+    NEW_LINE_ATTRIBUTE,
+    NEW_LINE_VALUE,
+    NEW_LINE_ERROR,
+    INCLUDE_FILE,
+    START_SECTION,
+    END_SECTION,
+    PUSH_INHERITANCE,
+    PUSH_ATTRIBUTE,
+    START_ARRAY,
+    START_INHERITANCE,
+    START_ATTRIBUTE,
+    END_INHERITANCE,
+    END_KEY
+};
+
+enum class ParseMessage : uint8_t
+{
+    NONE = 0u,
+    SPACE,
+    UNKNOWN_ESCAPE,
+    UNEXPECTED_ESCAPE,
+    PREPROCESSOR,
+    NEW_LINE,
+    SECTION_NAMING,
+    ENUMERATION,
+    INHERITANCE,
+    SET_VALUE,
+    INVALID_CHARACTER,
+    COUNT
+};
+
+static constexpr std::array<std::string_view, static_cast<size_t>(ParseMessage::COUNT)> parse_messages
+{
+    "",
+    "Space in wrong place",
+    "Unknown escape-sequence symbol",
+    "Unexpected escape-symbol",
+    "Preprocessor parse error",
+    "New line parse error",
+    "Section naming parse error",
+    "Enumeration error",
+    "Inheritance error",
+    "Set value error",
+    "Invalid character error"
+};
+
+struct Transition final
+{
+    TokenOperation operation;
+    ParseMessage message;
+};
+
+static constexpr std::array<CharacterClass, 256u> makeCharacterClasses()
+{
+    std::array<CharacterClass, 256u> classes {};
+
+    classes[static_cast<uint8_t>(';')] = CharacterClass::COMMENT;
+    classes[static_cast<uint8_t>('|')] = CharacterClass::MULTILINE_COMMENT;
+    classes[static_cast<uint8_t>(' ')] = CharacterClass::SPACE;
+    classes[static_cast<uint8_t>('\t')] = CharacterClass::SPACE;
+    classes[static_cast<uint8_t>('\\')] = CharacterClass::ESCAPE;
+    classes[static_cast<uint8_t>('\"')] = CharacterClass::QUOTE;
+    classes[static_cast<uint8_t>('#')] = CharacterClass::PREPROCESSOR;
+    classes[static_cast<uint8_t>('\n')] = CharacterClass::NEW_LINE;
+    classes[static_cast<uint8_t>('<')] = CharacterClass::INCLUDE_BEGIN;
+    classes[static_cast<uint8_t>('>')] = CharacterClass::INCLUDE_END;
+    classes[static_cast<uint8_t>('[')] = CharacterClass::SECTION_BEGIN;
+    classes[static_cast<uint8_t>(']')] = CharacterClass::SECTION_END;
+    classes[static_cast<uint8_t>(',')] = CharacterClass::ENUMERATION;
+    classes[static_cast<uint8_t>(':')] = CharacterClass::INHERITANCE;
+    classes[static_cast<uint8_t>('=')] = CharacterClass::ASSIGNMENT;
+
+    return classes;
+}
+
+/**
+    \brief Grammar rules, evaluated only at compile time to fill the transition table.
+*/
+static constexpr Transition makeTransition(const ParseAction state, const CharacterClass character_class)
+{
+    const bool in_comment = (state == ParseAction::COMMENT) || (state == ParseAction::MULTILINE_COMMENT);
+    const bool in_string = (state == ParseAction::STRING_VALUE);
+
+    const auto Do = [](const TokenOperation operation) -> Transition
+    {
+        return {operation, ParseMessage::NONE};
+    };
+
+    const auto Fail = [](const ParseMessage message) -> Transition
+    {
+        return {TokenOperation::ERROR, message};
+    };
+
+    switch (character_class)
+    {
+        case CharacterClass::COMMENT:
+            return Do(in_string ? TokenOperation::APPEND_CHARACTER : TokenOperation::START_COMMENT);
+
+        case CharacterClass::MULTILINE_COMMENT:
+        {
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            if (state == ParseAction::MULTILINE_COMMENT)
+                return Do(TokenOperation::END_MULTILINE_COMMENT);
+
+            return Do(TokenOperation::START_MULTILINE_COMMENT);
+        }
+
+        case CharacterClass::SPACE:
+        {
+            switch (state)
+            {
+                case ParseAction::STRING_VALUE:
+                    return Do(TokenOperation::APPEND_CHARACTER);
+
+                case ParseAction::PREPROCESSOR:
+                    return Do(TokenOperation::PREPROCESSOR_SPACE);
+
+                case ParseAction::ATTRIBUTE:
+                case ParseAction::INHERITANCE:
+                case ParseAction::KEY:
+                case ParseAction::SECTION:
+                case ParseAction::VALUE:
+                    return {TokenOperation::CHECK_SPACE, ParseMessage::SPACE};
+
+                default:
+                    return Do(TokenOperation::NONE);
+            }
+        }
+
+        case CharacterClass::ESCAPE:
+        {
+            if (in_comment)
+                return Do(TokenOperation::NONE);
+
+            if (in_string)
+                return {TokenOperation::ESCAPE, ParseMessage::UNKNOWN_ESCAPE};
+
+            return Fail(ParseMessage::UNEXPECTED_ESCAPE);
+        }
+
+        case CharacterClass::QUOTE:
+        {
+            if (in_string)
+                return Do(TokenOperation::END_STRING);
+
+            if (state == ParseAction::VALUE)
+                return Do(TokenOperation::START_STRING);
+
+            return Do(TokenOperation::NONE);
+        }
+
+        case CharacterClass::PREPROCESSOR:
+        {
+            if (in_comment)
+                return Do(TokenOperation::NONE);
+
+            if (state == ParseAction::NEW_LINE)
+                return Do(TokenOperation::START_PREPROCESSOR);
+
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            return Fail(ParseMessage::PREPROCESSOR);
+        }
+
+        case CharacterClass::NEW_LINE:
+        {
+            switch (state)
+            {
+                case ParseAction::INHERITANCE:
+                    return Do(TokenOperation::NEW_LINE_INHERITANCE);
+
+                case ParseAction::ATTRIBUTE:
+                    return Do(TokenOperation::NEW_LINE_ATTRIBUTE);
+
+                case ParseAction::VALUE:
+                case ParseAction::VALUE_ARRAY:
+                    return Do(TokenOperation::NEW_LINE_VALUE);
+
+                case ParseAction::COMMENT:
+                case ParseAction::MULTILINE_COMMENT:
+                case ParseAction::PREPROCESSOR:
+                case ParseAction::INCLUDE:
+                case ParseAction::STRING_VALUE:
+                case ParseAction::NEW_LINE:
+                case ParseAction::SECTION:
+                    return Do(TokenOperation::NEW_LINE);
+
+                default:
+                    return {TokenOperation::NEW_LINE_ERROR, ParseMessage::NEW_LINE};
+            }
+        }
+
+        case CharacterClass::INCLUDE_BEGIN:
+            return Do(in_string ? TokenOperation::APPEND_CHARACTER : TokenOperation::NONE);
+
+        case CharacterClass::INCLUDE_END:
+        {
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            if (state == ParseAction::INCLUDE)
+                return Do(TokenOperation::INCLUDE_FILE);
+
+            return Do(TokenOperation::NONE);
+        }
+
+        case CharacterClass::SECTION_BEGIN:
+        {
+            if (in_comment)
+                return Do(TokenOperation::NONE);
+
+            if (state == ParseAction::NEW_LINE)
+                return Do(TokenOperation::START_SECTION);
+
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            return Fail(ParseMessage::SECTION_NAMING);
+        }
+
+        case CharacterClass::SECTION_END:
+        {
+            if (in_comment)
+                return Do(TokenOperation::NONE);
+
+            if (state == ParseAction::SECTION)
+                return Do(TokenOperation::END_SECTION);
+
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            return Fail(ParseMessage::SECTION_NAMING);
+        }
+
+        case CharacterClass::ENUMERATION:
+        {
+            switch (state)
+            {
+                case ParseAction::COMMENT:
+                case ParseAction::MULTILINE_COMMENT:
+                    return Do(TokenOperation::NONE);
+
+                case ParseAction::INHERITANCE:
+                    return Do(TokenOperation::PUSH_INHERITANCE);
+
+                case ParseAction::ATTRIBUTE:
+                    return Do(TokenOperation::PUSH_ATTRIBUTE);
+
+                case ParseAction::STRING_VALUE:
+                case ParseAction::VALUE_ARRAY:
+                    return Do(TokenOperation::APPEND_CHARACTER);
+
+                case ParseAction::VALUE:
+                    return Do(TokenOperation::START_ARRAY);
+
+                default:
+                    return Fail(ParseMessage::ENUMERATION);
+            }
+        }
+
+        case CharacterClass::INHERITANCE:
+        {
+            if (in_comment)
+                return Do(TokenOperation::NONE);
+
+            if (state == ParseAction::SECTION)
+                return Do(TokenOperation::START_INHERITANCE);
+
+            if (in_string)
+                return Do(TokenOperation::APPEND_CHARACTER);
+
+            return Fail(ParseMessage::INHERITANCE);
+        }
+
+        case CharacterClass::ASSIGNMENT:
+        {
+            switch (state)
+            {
+                case ParseAction::COMMENT:
+                case ParseAction::MULTILINE_COMMENT:
+                    return Do(TokenOperation::NONE);
+
+                case ParseAction::SECTION:
+                    return Do(TokenOperation::START_ATTRIBUTE);
+
+                case ParseAction::INHERITANCE:
+                    return Do(TokenOperation::END_INHERITANCE);
+
+                case ParseAction::KEY:
+                    return Do(TokenOperation::END_KEY);
+
+                case ParseAction::STRING_VALUE:
+                    return Do(TokenOperation::APPEND_CHARACTER);
+
+                default:
+                    return Fail(ParseMessage::SET_VALUE);
+            }
+        }
+
+        default:
+        {
+            switch (state)
+            {
+                case ParseAction::COMMENT:
+                case ParseAction::MULTILINE_COMMENT:
+                    return Do(TokenOperation::SKIP_RUN);
+
+                case ParseAction::NEW_LINE:
+                    return Do(TokenOperation::START_KEY);
+
+                case ParseAction::PREPROCESSOR:
+                    return Do(TokenOperation::APPEND_PREPROCESSOR);
+
+                case ParseAction::INCLUDE:
+                    return Do(TokenOperation::APPEND_INCLUDE);
+
+                case ParseAction::SECTION:
+                    return Do(TokenOperation::APPEND_SECTION);
+
+                case ParseAction::INHERITANCE:
+                    return Do(TokenOperation::APPEND_INHERITANCE);
+
+                case ParseAction::ATTRIBUTE:
+                    return Do(TokenOperation::APPEND_ATTRIBUTE);
+
+                case ParseAction::KEY:
+                    return Do(TokenOperation::APPEND_KEY);
+
+                case ParseAction::VALUE:
+                case ParseAction::VALUE_ARRAY:
+                case ParseAction::STRING_VALUE:
+                    return Do(TokenOperation::APPEND_VALUE);
+
+                default:
+                    return Fail(ParseMessage::INVALID_CHARACTER);
+            }
+        }
+    }
+}
+
+static constexpr size_t state_count {static_cast<size_t>(ParseAction::ERROR) + 1u};
+static constexpr size_t character_class_count {static_cast<size_t>(CharacterClass::COUNT)};
+
+using TransitionTable = std::array<std::array<Transition, character_class_count>, state_count>;
+
+static constexpr TransitionTable makeTransitionTable()
+{
+    TransitionTable table {};
+
+    for (size_t state = 0u; state < state_count; ++state)
+    {
+        for (size_t character_class = 0u; character_class < character_class_count; ++character_class)
+        {
+            table[state][character_class] = makeTransition(static_cast<ParseAction>(state),
+                static_cast<CharacterClass>(character_class));
+        }
+    }
+
+    return table;
+}
+
+static constexpr std::array<CharacterClass, 256u> character_classes {makeCharacterClasses()};
+static constexpr TransitionTable transition_table {makeTransitionTable()};
+
+// Every character with own class has to stop a literal run
+static constexpr bool checkCharacterClasses()
+{
+    for (uint32_t byte = 0u; byte < 256u; ++byte)
+    {
+        const auto& structural = StructuralScanner::structural_characters;
+
+        if ((character_classes[byte] != CharacterClass::LITERAL) &&
+            (std::find(structural.cbegin(), structural.cend(), static_cast<char>(byte)) == structural.cend()))
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(checkCharacterClasses(), "Scanner does not stop at some grammar character");
+
+/**
+    \brief Tokenizer state. Carried from one piece of input to the next one.
+*/
+struct CFGParser::ParseState final
+{
+    Token section, inheritance, attribute, key, value;
+    std::pair<std::string, std::string> preprocessor_pair;
+
+    Section* section_ptr = nullptr;
+    ValueSlot* value_ptr = nullptr;
+
+    // Table which holds the section, chunk which is parsed again continues a section of previous chunk
+    SectionDataHash* section_table = nullptr;
+
+    ParseAction parse_action = ParseAction::NEW_LINE;
+
+    uint32_t line = 1u, character_pos = 0u;
+    bool ignore_current_spaces = true;
+
+    /**
+        \brief Checks that nothing is pending after a line break, so the next line parses
+        the same way as from state made by startLine().
+    */
+    const bool isClean() const noexcept
+    {
+        return (parse_action == ParseAction::NEW_LINE) && (character_pos == 1u) && ignore_current_spaces &&
+            inheritance.empty() && attribute.empty() && key.empty() && value.empty() &&
+            preprocessor_pair.first.empty() && preprocessor_pair.second.empty();
+    }
+
+    /**
+        \brief State right after a line break, character counter is already past it.
+    */
+    void startLine() noexcept
+    {
+        character_pos = 1u;
+    }
+};
+
+/**
+    \brief Everything which depends on data outside of parsed piece is recorded
+    and resolved later, when the piece is merged in order.
+*/
+struct CFGParser::ParseEvent final
+{
+    enum class Type : uint8_t
+    {
+        MESSAGE = 0u,
+        SECTION_MESSAGE,
+        SECTION,
+        INHERITANCE,
+        INCLUDE
+    };
+
+    Type type;
+    uint32_t line, character_pos;
+
+    // Section or inheritance symbol, name and parsed data for SECTION
+    Symbol symbol;
+    std::string_view name;
+    Section* section;
+
+    // Message or include path
+    std::string text;
+};
+
+/**
+    \brief Parsed piece of input. Deferred chunks are parsed into own tables and are not
+    visible until merged, otherwise everything goes right into parser data.
+*/
+struct CFGParser::ParseChunk final
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    bool deferred = true;
+
+    SectionDataHash sections;
+    StringArena strings;
+    std::vector<ParseEvent> events;
+
+    // Names this chunk has already interned, keyed by the interned copy
+    std::unordered_map<std::string_view, Symbol> symbols;
+
+    // Chunks are parsed from line 1, this gets added on merge
+    uint32_t line_offset = 0u;
+
+    ParseState final_state;
+};
+
+/**
+    \brief Included file parsed ahead of its merge.
+*/
+struct CFGParser::IncludedFile final
+{
+    MappedFile file;
+    ParseChunk chunk;
+};
+
+/**
+    \brief Same file may be included through different relative paths.
+*/
+static std::string canonicalPath(const std::string& file_path)
+{
+    std::error_code error;
+    const auto path = std::filesystem::weakly_canonical(file_path, error);
+
+    return error ? file_path : path.string();
+}
+
 CFGParser::CFGParser() noexcept
 {
     _msg_functor = std::move([](const std::string& msg)
@@ -27,248 +665,974 @@ CFGParser::CFGParser() noexcept
     });
 }
 
-CFGParser::CFGParser(const std::string& file_path) noexcept
+CFGParser::CFGParser(const std::string& file_path) noexcept
+{
+    _msg_functor = std::move([](const std::string& msg)
+    {
+        std::cout << "CFGParser: " << msg << std::endl;
+    });
+
+    this->load(file_path);
+}
+
+CFGParser::~CFGParser() noexcept
+{
+    this->dropPrefetched();
+}
+
+const bool CFGParser::hasAttribute(std::string_view section, std::string_view attribute) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section)); section_data != nullptr)
+    {
+        if (const auto bit = _attribute_bits.find(_symbols.find(attribute)); bit != nullptr)
+            return section_data->attribute_set.test(*bit);
+    }
+
+    return false;
+}
+
+const bool CFGParser::hasAttributes(std::string_view section) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        return (!section_data->attributes.empty());
+    }
+    else
+    {
+        if (_msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
+    }
+
+    return false;
+}
+
+const std::vector<CFGParser::Symbol>& CFGParser::getAttributes(std::string_view section) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        return section_data->attributes;
+    }
+    else
+    {
+        if (_msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
+    }
+
+    return _dummy;
+}
+
+const std::vector<CFGParser::Symbol>& CFGParser::getSectionsWithAttribute(std::string_view attribute) const noexcept
+{
+    if (const auto bit = _attribute_bits.find(_symbols.find(attribute)); bit != nullptr)
+        return _attribute_sections[*bit];
+
+    return _dummy;
+}
+
+std::vector<CFGParser::Symbol> CFGParser::getSectionsWithAllAttributes(const std::vector<std::string_view>& attributes) const
+{
+    std::vector<const std::vector<Symbol>*> lists;
+
+    for (const auto attribute : attributes)
+    {
+        const auto bit = _attribute_bits.find(_symbols.find(attribute));
+
+        if (bit == nullptr)
+            return {};
+
+        lists.push_back(&_attribute_sections[*bit]);
+    }
+
+    if (lists.empty())
+        return {};
+
+    // Rarest attribute first, so the result only shrinks from there
+    std::sort(lists.begin(), lists.end(), [](const auto* left, const auto* right) { return left->size() < right->size(); });
+
+    std::vector<Symbol> result(*lists.front());
+    std::vector<Symbol> intersection;
+
+    for (size_t list = 1u; (list < lists.size()) && !result.empty(); ++list)
+    {
+        intersection.clear();
+        std::set_intersection(result.cbegin(), result.cend(), lists[list]->cbegin(), lists[list]->cend(), std::back_inserter(intersection));
+        std::swap(result, intersection);
+    }
+
+    return result;
+}
+
+std::vector<CFGParser::Symbol> CFGParser::getSectionsWithAnyAttribute(const std::vector<std::string_view>& attributes) const
+{
+    std::vector<Symbol> result;
+
+    for (const auto attribute : attributes)
+    {
+        if (const auto bit = _attribute_bits.find(_symbols.find(attribute)); bit != nullptr)
+        {
+            const auto& sections = _attribute_sections[*bit];
+            const size_t middle = result.size();
+
+            result.insert(result.end(), sections.cbegin(), sections.cend());
+            std::inplace_merge(result.begin(), result.begin() + middle, result.end());
+        }
+    }
+
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+}
+
+const bool CFGParser::hasSection(std::string_view section) const noexcept
+{
+    if (_frozen != nullptr)
+        return (_frozen->findSection(section) != nullptr);
+
+    return (_section_data.find(_symbols.find(section)) != nullptr);
+}
+
+const bool CFGParser::hasKey(std::string_view section, std::string_view key) const noexcept
+{
+    if (const auto frozen_section = (_frozen != nullptr) ? _frozen->findSection(section) : nullptr;
+        frozen_section != nullptr)
+    {
+        const auto frozen_key = _frozen->findKey(*frozen_section, key);
+        return (frozen_key != nullptr) && frozen_key->own;
+    }
+    else if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        return (_section_data.findValue(*section_data, _symbols.find(key)) != nullptr);
+    }
+    else
+    {
+        if (_msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
+    }
+
+    return false;
+}
+
+const bool CFGParser::isInheritedFrom(std::string_view section, std::string_view base_section) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        const Symbol base_symbol = _symbols.find(base_section);
+
+        for (const auto inherited : section_data->inheritances)
+        {
+            if (inherited == base_symbol)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+const std::vector<CFGParser::Symbol>& CFGParser::getDerivedSections(std::string_view base_section) const noexcept
+{
+    if (const auto sections = _derived_sections.find(_symbols.find(base_section)); sections != nullptr)
+        return *sections;
+
+    return _dummy;
+}
+
+std::vector<CFGParser::Symbol> CFGParser::getAllDerivedSections(std::string_view base_section) const
+{
+    const Symbol base = _symbols.find(base_section);
+
+    if (_derived_sections.find(base) == nullptr)
+        return {};
+
+    // Breadth-first over reverse edges, result doubles as the queue
+    std::vector<Symbol> result;
+    std::vector<bool> visited(_symbols.size(), false);
+    visited[base] = true;
+
+    const auto Visit = [this, &result, &visited](const Symbol section) -> void
+    {
+        if (const auto derived = _derived_sections.find(section); derived != nullptr)
+        {
+            for (const auto derived_section : *derived)
+            {
+                if (!visited[derived_section])
+                {
+                    visited[derived_section] = true;
+                    result.push_back(derived_section);
+                }
+            }
+        }
+    };
+
+    Visit(base);
+
+    for (size_t next = 0u; next < result.size(); ++next)
+        Visit(result[next]);
+
+    return result;
+}
+
+const bool CFGParser::hasInheritances(std::string_view section) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        return (!section_data->inheritances.empty());
+    }
+    else
+    {
+        if (_msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
+    }
+
+    return false;
+}
+
+const std::vector<CFGParser::Symbol>& CFGParser::getInheritances(std::string_view section) const noexcept
+{
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        return section_data->inheritances;
+    }
+    else
+    {
+        if (_msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
+    }
+
+    return _dummy;
+}
+
+std::string_view CFGParser::getString(std::string_view section, std::string_view key, std::string_view default_value) const noexcept
+{
+    if (const auto value = this->findValue(section, key); value != nullptr)
+    {
+        // View cannot be guarded, any set() from another thread may overwrite it
+        if ((_value_shards != nullptr) && _msg_functor)
+            _msg_functor("Section \"" + std::string(section) + "\" key \"" + std::string(key) + "\" is read by getString() in concurrent mode, use copyString()!");
+
+        return value->view();
+    }
+
+    return default_value;
+}
+
+std::string CFGParser::copyString(std::string_view section, std::string_view key, std::string_view default_value) const
+{
+    if (const auto value = this->findValue(section, key); value != nullptr)
+        return this->copyText(value);
+
+    return std::string(default_value);
+}
+
+std::string CFGParser::copyString(const Handle& handle, std::string_view default_value) const
+{
+    if (this->isValid(handle) && (handle.value != nullptr))
+        return this->copyText(handle.value);
+
+    return std::string(default_value);
+}
+
+std::string CFGParser::copyText(const ValueSlot* const value) const
+{
+    const auto lock = this->lockValue(value);
+
+    return std::string(value->view());
+}
+
+CFGParser::Handle CFGParser::resolve(std::string_view section, std::string_view key) const noexcept
+{
+    return Handle {this->findValue(section, key), _generation};
+}
+
+std::string_view CFGParser::getString(const Handle& handle, std::string_view default_value) const noexcept
+{
+    if (this->isValid(handle) && (handle.value != nullptr))
+    {
+        if ((_value_shards != nullptr) && _msg_functor)
+            _msg_functor("Value is read by getString() in concurrent mode, use copyString()!");
+
+        return handle.value->view();
+    }
+
+    return default_value;
+}
+
+const ValueSlot* CFGParser::findValue(std::string_view section, std::string_view key) const noexcept
+{
+    // Names are not turned into symbols, frozen index is keyed by the names themselves
+    if (_frozen != nullptr)
+    {
+        if (const auto frozen_section = _frozen->findSection(section); frozen_section != nullptr)
+        {
+            if (const auto frozen_key = _frozen->findKey(*frozen_section, key); frozen_key != nullptr)
+                return frozen_key->value;
+        }
+
+        return nullptr;
+    }
+
+    if (const auto section_data = _section_data.find(_symbols.find(section));
+        section_data != nullptr)
+    {
+        const Symbol key_symbol = _symbols.find(key);
+
+        if (section_data->inheritances.empty())
+        {
+            return _section_data.findValue(*section_data, key_symbol);
+        }
+        // So... If we found value in inherited section only - we return it.
+        // But! If we have same keys inside all inherited sections?
+        // Hmm... Should we return a first value? Well, let it be for now.
+        // So, inheritance priority will be...
+        // [section] : higher, middle, lower
+        else if (const auto value = section_data->effective_values.find(key_symbol);
+            value != nullptr)
+        {
+            return *value;
+        }
+    }
+
+    return nullptr;
+}
+
+void CFGParser::reportConversion(std::string_view section, std::string_view key, std::string_view value, const ConversionError error) const noexcept
 {
-    _msg_functor = std::move([](const std::string& msg)
-    {
-        std::cout << "CFGParser: " << msg << std::endl;
-    });
+    if (!_msg_functor)
+        return;
 
-    this->load(file_path);
+    std::string message = section.empty() ?
+        "Value \"" + std::string(value) + "\"" :
+        "Section \"" + std::string(section) + "\" key \"" + std::string(key) + "\" value \"" + std::string(value) + "\"";
+
+    if (error == ConversionError::OUT_OF_RANGE)
+        message += " is out of range!";
+    else
+        message += " is not a valid number!";
+
+    _msg_functor(message);
 }
 
-const bool CFGParser::hasAttribute(const std::string& section, const std::string& attribute) const noexcept
+void CFGParser::link()
 {
-    if (const auto iter = _section_data.find(section); iter != _section_data.cend())
+    enum class LinkState : uint8_t
+    {
+        UNLINKED,
+        LINKING,
+        LINKED
+    };
+
+    struct LinkFrame final
+    {
+        Symbol symbol;
+        Section* section;
+        size_t next_base;
+    };
+
+    // Symbols are dense, so state is just indexed by them
+    std::vector<LinkState> states(_symbols.size(), LinkState::UNLINKED);
+    std::vector<LinkFrame> stack;
+
+    std::vector<const Section*> bases;
+
+    const auto MergeBases = [this, &states, &bases](Section& section) -> void
     {
-        for (const auto& section_attribute : iter->second.attributes)
+        auto& effective_values = section.effective_values;
+        effective_values.clear();
+
+        if (section.inheritances.empty())
+            return;
+
+        // Base which is still being linked is a cycle edge, it is already reported
+        bases.clear();
+        size_t value_count = section.valueCount();
+
+        for (const auto base : section.inheritances)
         {
-            if (section_attribute == attribute)
-                return true;
+            if (states[base] != LinkState::LINKED)
+                continue;
+
+            const auto base_section = _section_data.find(base);
+            bases.push_back(base_section);
+
+            value_count += base_section->inheritances.empty() ? base_section->valueCount() : base_section->effective_values.size();
+        }
+
+        effective_values.reserve(value_count);
+
+        for (const auto& [key, value] : _section_data.values(section))
+            effective_values.try_emplace(key, &value);
+
+        for (const auto base_section : bases)
+        {
+            if (base_section->inheritances.empty())
+            {
+                for (const auto& [key, value] : _section_data.values(*base_section))
+                    effective_values.try_emplace(key, &value);
+            }
+            else
+            {
+                for (const auto& [key, value] : base_section->effective_values)
+                    effective_values.try_emplace(key, value);
+            }
+        }
+    };
+
+    _attribute_bits.clear();
+    _attribute_sections.clear();
+    _derived_sections.clear();
+
+    // Depth-first, so every base is linked before sections which inherit it
+    for (auto& [symbol, section] : _section_data)
+    {
+        section.attribute_set.clear();
+
+        for (const auto attribute : section.attributes)
+        {
+            const auto [bit, inserted] = _attribute_bits.try_emplace(attribute, static_cast<uint32_t>(_attribute_sections.size()));
+
+            if (inserted)
+                _attribute_sections.emplace_back();
+
+            if (!section.attribute_set.test(*bit))
+            {
+                section.attribute_set.set(*bit);
+                _attribute_sections[*bit].push_back(symbol);
+            }
+        }
+
+        for (const auto base : section.inheritances)
+            _derived_sections.try_emplace(base, {}).first->push_back(symbol);
+
+        if (states[symbol] != LinkState::UNLINKED)
+            continue;
+
+        states[symbol] = LinkState::LINKING;
+        stack.push_back({symbol, &section, 0u});
+
+        while (!stack.empty())
+        {
+            auto& frame = stack.back();
+
+            if (frame.next_base == frame.section->inheritances.size())
+            {
+                MergeBases(*frame.section);
+                states[frame.symbol] = LinkState::LINKED;
+                stack.pop_back();
+
+                continue;
+            }
+
+            const Symbol base = frame.section->inheritances[frame.next_base++];
+
+            if (states[base] == LinkState::LINKING)
+            {
+                if (_msg_functor)
+                {
+                    std::string cycle;
+
+                    for (auto iter = std::find_if(stack.cbegin(), stack.cend(), [base](const LinkFrame& cycle_frame) { return cycle_frame.symbol == base; });
+                        iter != stack.cend(); ++iter)
+                        cycle += "\"" + std::string(_symbols.name(iter->symbol)) + "\" -> ";
+
+                    _msg_functor("Inheritance cycle " + cycle + "\"" + std::string(_symbols.name(base)) + "\".");
+                }
+            }
+            else if (states[base] == LinkState::UNLINKED)
+            {
+                states[base] = LinkState::LINKING;
+                stack.push_back({base, _section_data.find(base), 0u});
+            }
         }
     }
 
-    return false;
+    for (auto& sections : _attribute_sections)
+        std::sort(sections.begin(), sections.end());
+
+    // Base may be listed twice by the same section
+    for (auto& [base, sections] : _derived_sections)
+    {
+        std::sort(sections.begin(), sections.end());
+        sections.erase(std::unique(sections.begin(), sections.end()), sections.end());
+    }
+
+    // Inherited values point to the same slots, so they get the blobs too
+    if (_typed_array_builder != nullptr)
+    {
+        for (auto& [symbol, section] : _section_data)
+        {
+            for (const auto& [key, value] : _section_data.values(section))
+            {
+                if (!value.hasArray() && (value.view().find(',') != std::string_view::npos))
+                    _typed_array_builder(value, _strings);
+            }
+        }
+    }
 }
 
-const bool CFGParser::hasAttributes(const std::string& section) const noexcept
+void CFGParser::load(const std::string& file_path)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
+    if (_frozen != nullptr)
     {
-        return (!iter->second.attributes.empty());
+        if (_msg_functor)
+            _msg_functor("Config is frozen, file \"" + file_path + "\" cannot be loaded!");
+
+        return;
     }
-    else
+
+    _current_file = file_path;
+
+    MappedFile file(_current_file);
+
+    if (!file.isOpen())
     {
         if (_msg_functor)
-            _msg_functor("Section \"" + section + "\" is not exist!");
+            _msg_functor("Cannot open file \"" + file_path + "\".");
+
+        return;
     }
 
-    return false;
+    const auto path = canonicalPath(file_path);
+
+    _included_files.insert(path);
+    _include_stack.push_back(path);
+
+    this->prefetchIncludes(file.begin(), file.end());
+    this->parse(file.begin(), file.end());
+
+    _include_stack.pop_back();
+
+    if (_include_stack.empty())
+    {
+        this->dropPrefetched();
+        this->link();
+    }
+
+    // Parsed data points right into the mapping
+    if (_retain_source)
+        _sources.push_back(std::move(file));
 }
 
-const std::vector<std::string>& CFGParser::getAttributes(const std::string& section) const noexcept
+void CFGParser::loadFromMemory(std::string_view data)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
+    if (_frozen != nullptr)
     {
-        return iter->second.attributes;
+        if (_msg_functor)
+            _msg_functor("Config is frozen, nothing can be loaded!");
+
+        return;
     }
-    else
+
+    _current_file.clear();
+
+    // Data has no path, but it is still the root of include graph
+    _include_stack.emplace_back();
+
+    this->prefetchIncludes(data.data(), data.data() + data.size());
+    this->parse(data.data(), data.data() + data.size());
+
+    _include_stack.pop_back();
+
+    if (_include_stack.empty())
     {
-        if (_msg_functor)
-            _msg_functor("Section \"" + section + "\" is not exist!");
+        this->dropPrefetched();
+        this->link();
     }
+}
 
-    return _dummy;
+void CFGParser::stream(const std::string& file_path, Visitor& visitor)
+{
+    this->runStream(visitor, [this, &file_path]() { this->streamFile(file_path); });
 }
 
-const bool CFGParser::hasSection(const std::string& section) const noexcept
+void CFGParser::streamFromMemory(std::string_view data, Visitor& visitor)
 {
-    return (_section_data.find(section) != _section_data.cend());
+    this->runStream(visitor, [this, data]() { this->streamRange(data.data(), data.data() + data.size()); });
 }
 
-const bool CFGParser::hasKey(const std::string& section, const std::string& key) const noexcept
+void CFGParser::runStream(Visitor& visitor, const std::function<void()>& body)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
-    {
-        return (iter->second.values.find(key) != iter->second.values.cend());
-    }
-    else
+    // Streamed config has its own include graph, loaded data is not related to it
+    auto included_files = std::exchange(_included_files, {});
+    auto include_stack = std::exchange(_include_stack, {});
+
+    _visitor = &visitor;
+
+    body();
+
+    _visitor = nullptr;
+    _included_files = std::move(included_files);
+    _include_stack = std::move(include_stack);
+}
+
+void CFGParser::streamFile(const std::string& file_path)
+{
+    MappedFile file(file_path);
+
+    if (!file.isOpen())
     {
-        if (_msg_functor)
-            _msg_functor("Section \"" + section + "\" is not exist!");
+        _visitor->onError("Cannot open file \"" + file_path + "\".");
+        return;
     }
 
-    return false;
+    const auto path = canonicalPath(file_path);
+
+    _included_files.insert(path);
+    _include_stack.push_back(path);
+
+    this->streamRange(file.begin(), file.end(), &file);
+
+    _include_stack.pop_back();
 }
 
-const bool CFGParser::isInheritedFrom(const std::string& section, const std::string& base_section) const noexcept
+void CFGParser::streamRange(const char* const begin, const char* const end, MappedFile* const file)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
+    ParseState state;
+    ParseChunk chunk;
+    chunk.deferred = false;
+
+    // Windows end right after a line break, state carries everything else over.
+    // Parsed part of the file is let go, so resident memory stays the same for any file size.
+    for (const char* window_begin = begin; window_begin != end;)
     {
-        for (const auto& inherited : iter->second.inheritances)
+        const char* window_end = end;
+
+        if (static_cast<size_t>(end - window_begin) > stream_window_size)
         {
-            if (inherited == base_section)
-                return true;
+            const char* const position = static_cast<const char*>(std::memchr(window_begin + stream_window_size, '\n',
+                static_cast<size_t>(end - window_begin) - stream_window_size));
+
+            if (position != nullptr)
+                window_end = position + 1;
         }
+
+        this->parseChunk(window_begin, window_end, state, chunk);
+
+        if (file != nullptr)
+            file->release(window_end);
+
+        window_begin = window_end;
     }
+}
 
-    return false;
+const uint32_t CFGParser::getThreadCount() const noexcept
+{
+    return (_thread_count != 0u) ? _thread_count : std::max(1u, std::thread::hardware_concurrency());
 }
 
-const bool CFGParser::hasInheritances(const std::string& section) const noexcept
+void CFGParser::prefetchIncludes(const char* const begin, const char* const end)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
-    {
-        return (!iter->second.inheritances.empty());
-    }
-    else
+    if (this->getThreadCount() < 2u)
+        return;
+
+    // Quick look for "#include <path>", it does not know about strings and comments
+    // but a wrong guess only costs a wasted parse
+    static constexpr std::string_view directive {"#include"};
+
+    for (const char* position = begin; position < end; ++position)
     {
-        if (_msg_functor)
-            _msg_functor("Section \"" + section + "\" is not exist!");
-    }
+        position = static_cast<const char*>(std::memchr(position, '#', static_cast<size_t>(end - position)));
 
-    return false;
+        if (position == nullptr)
+            break;
+
+        if ((static_cast<size_t>(end - position) <= directive.size()) ||
+            (std::string_view(position, directive.size()) != directive))
+            continue;
+
+        position += directive.size();
+
+        if ((*position != ' ') && (*position != '\t'))
+            continue;
+
+        while ((position < end) && ((*position == ' ') || (*position == '\t')))
+            ++position;
+
+        if ((position == end) || (*position != '<'))
+            continue;
+
+        std::string include_path;
+
+        while ((++position < end) && (*position != '>') && (*position != '\n'))
+        {
+            if ((*position != ' ') && (*position != '\t'))
+                include_path += *position;
+        }
+
+        if ((position < end) && (*position == '>') && !include_path.empty())
+            this->prefetchInclude(_base_path + include_path);
+    }
 }
 
-const std::vector<std::string>& CFGParser::getInheritances(const std::string& section) const noexcept
+void CFGParser::prefetchInclude(const std::string& file_path)
 {
-    if (const auto iter = _section_data.find(section);
-        iter != _section_data.cend())
-    {
-        return iter->second.inheritances;
-    }
-    else
+    auto path = canonicalPath(file_path);
+
+    std::lock_guard<std::mutex> lock(_prefetch_mutex);
+
+    if (_prefetched.count(path) != 0u)
+        return;
+
+    _prefetched.emplace(std::move(path), std::async(std::launch::async, [this, file_path]() -> std::unique_ptr<IncludedFile>
     {
-        if (_msg_functor)
-            _msg_functor("Section \"" + section + "\" is not exist!");
-    }
+        auto included = std::make_unique<IncludedFile>();
 
-    return _dummy;
+        if (included->file.open(file_path))
+        {
+            auto& chunk = included->chunk;
+            chunk.begin = included->file.begin();
+            chunk.end = included->file.end();
+
+            this->parseChunk(chunk.begin, chunk.end, chunk.final_state, chunk);
+
+            // Includes of this file are exact, no need to guess
+            for (const auto& event : chunk.events)
+            {
+                if (event.type == ParseEvent::Type::INCLUDE)
+                    this->prefetchInclude(_base_path + event.text);
+            }
+        }
+
+        return included;
+    }));
 }
 
-const std::string& CFGParser::getString(const std::string& section, const std::string& key, const std::string& default_value) const noexcept
+std::unique_ptr<CFGParser::IncludedFile> CFGParser::takePrefetched(const std::string& path)
 {
-    if (const auto section_iter = _section_data.find(section);
-        section_iter != _section_data.cend())
+    std::future<std::unique_ptr<IncludedFile>> result;
+
     {
-        const auto& values = section_iter->second.values;
+        std::lock_guard<std::mutex> lock(_prefetch_mutex);
 
-        if (const auto value_iter = values.find(key);
-            value_iter != values.cend())
-            return value_iter->second;
+        const auto iter = _prefetched.find(path);
 
-        // So... If we found value in inherited section only - we return it.
-        // But! If we have same keys inside all inherited sections?
-        // Hmm... Should we return a first value? Well, let it be for now.
-        // So, inheritance priority will be...
-        // [section] : higher, middle, lower
-        if (const auto& value = this->getValueFromInheritance(section_iter->second, key); !value.empty())
-            return value;
+        if (iter == _prefetched.cend())
+            return nullptr;
 
-        return default_value;
-    }
-    else
-    {
-        return default_value;
+        result = std::move(iter->second);
+        _prefetched.erase(iter);
     }
+
+    return result.get();
 }
 
-const std::string& CFGParser::getValueFromInheritance(const Section& section_data, const std::string& key) const noexcept
+void CFGParser::dropPrefetched()
 {
-    for (const auto& inheritance : section_data.inheritances)
+    // Running parse may still add includes it has found, wait until nothing is left
+    for (;;)
     {
-        if (const auto iter = _section_data.find(inheritance);
-            iter != _section_data.cend())
+        std::unordered_map<std::string, std::future<std::unique_ptr<IncludedFile>>> prefetched;
+
         {
-            if (const auto key_iter = iter->second.values.find(key);
-                key_iter != iter->second.values.cend())
-            {
-                return key_iter->second;
-            }
+            std::lock_guard<std::mutex> lock(_prefetch_mutex);
+            prefetched.swap(_prefetched);
         }
-    }
 
-    return _dummy_str;
+        if (prefetched.empty())
+            break;
+
+        for (auto& pair : prefetched)
+            pair.second.wait();
+    }
 }
 
-void CFGParser::load(const std::string& file_path)
+void CFGParser::parse(const char* const begin, const char* const end)
 {
-    _current_file = file_path;
+    // New data may change what resolved handles should point to
+    ++_generation;
 
-    std::ifstream file(_current_file);
+    const uint32_t thread_count = this->getThreadCount();
+    const size_t size = static_cast<size_t>(end - begin);
 
-    if (!file.good())
+    if ((thread_count < 2u) || (size < (2u * min_chunk_size)))
     {
-        if (_msg_functor)
-            _msg_functor("Cannot open file \"" + file_path + "\".");
+        ParseState state;
+        ParseChunk chunk;
+        chunk.deferred = false;
+
+        this->parseChunk(begin, end, state, chunk);
 
         return;
     }
 
-    std::string section, inheritance, attribute, key, value;
-    std::pair<std::string, std::string> preprocessor_pair;
+    // Split at lines which start with a section header.
+    // Split point may turn out to be inside of a multiline string or comment block,
+    // so every chunk is parsed as if it started a new file and is parsed again
+    // later if previous chunk ends up in any other state.
+    std::vector<ParseChunk> chunks;
+    const size_t chunk_count = std::min<size_t>(thread_count * 4u, size / min_chunk_size);
+    const char* chunk_begin = begin;
+
+    for (size_t index = 1u; index < chunk_count; ++index)
+    {
+        const char* position = std::max(chunk_begin + 1, begin + (size / chunk_count) * index);
+
+        while (position < end)
+        {
+            position = static_cast<const char*>(std::memchr(position, '\n', static_cast<size_t>(end - position)));
+
+            if ((position == nullptr) || (++position == end) || (*position == '['))
+                break;
+        }
+
+        if ((position == nullptr) || (position >= end))
+            break;
+
+        chunks.emplace_back().begin = chunk_begin;
+        chunks.back().end = position;
+        chunk_begin = position;
+    }
+
+    chunks.emplace_back().begin = chunk_begin;
+    chunks.back().end = end;
+
+    std::atomic<size_t> next_chunk {0u};
+
+    const auto Worker = [&]() -> void
+    {
+        for (size_t index = next_chunk++; index < chunks.size(); index = next_chunk++)
+        {
+            auto& chunk = chunks[index];
+
+            if (index != 0u)
+                chunk.final_state.startLine();
+
+            this->parseChunk(chunk.begin, chunk.end, chunk.final_state, chunk);
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (uint32_t index = 1u; index < std::min<size_t>(thread_count, chunks.size()); ++index)
+        workers.emplace_back(Worker);
+
+    Worker();
+
+    for (auto& worker : workers)
+        worker.join();
+
+    // Validate chunk boundaries in order and redo the ones parsed with wrong starting state
+    for (size_t index = 1u; index < chunks.size(); ++index)
+    {
+        const auto& previous = chunks[index - 1u];
+        auto& chunk = chunks[index];
+
+        if (previous.final_state.isClean())
+        {
+            chunk.line_offset = previous.line_offset + previous.final_state.line - 1u;
+        }
+        else
+        {
+            ParseState state = previous.final_state;
+            state.line += previous.line_offset;
+
+            const char* const reparse_begin = chunk.begin;
+            const char* const reparse_end = chunk.end;
+
+            chunk = ParseChunk {};
+            chunk.begin = reparse_begin;
+            chunk.end = reparse_end;
+
+            this->parseChunk(reparse_begin, reparse_end, state, chunk);
+            chunk.final_state = std::move(state);
+        }
+    }
 
     Section* section_ptr = nullptr;
 
-    enum class ParseAction : uint8_t
+    for (auto& chunk : chunks)
+        this->mergeChunk(chunk, section_ptr);
+}
+
+void CFGParser::parseChunk(const char* const begin, const char* const end, ParseState& state, ParseChunk& chunk)
+{
+    auto& [section, inheritance, attribute, key, value, preprocessor_pair,
+        section_ptr, value_ptr, section_table, parse_action, line, character_pos, ignore_current_spaces] = state;
+
+    // Deferred chunk must not touch anything but itself, it is parsed on worker thread
+    SectionDataHash& sections = chunk.deferred ? chunk.sections : _section_data;
+    StringArena& strings = chunk.deferred ? chunk.strings : _strings;
+
+    // Streaming runs in direct mode, nothing is stored and section table is never touched
+    Visitor* const visitor = chunk.deferred ? nullptr : _visitor;
+    Section stream_section;
+    ValueSlot stream_value;
+
+    const auto Emit = [&](ParseEvent&& event) -> void
     {
-        NEW_LINE = 0u,
-        SECTION,
-        INHERITANCE,
-        ATTRIBUTE,
-        KEY,
-        VALUE,
-        VALUE_ARRAY,
-        STRING_VALUE,
-        COMMENT,
-        MULTILINE_COMMENT,
-        PREPROCESSOR,
-        INCLUDE,
-        ERROR
+        if (chunk.deferred)
+            chunk.events.push_back(std::move(event));
+        else
+            this->applyEvent(event, chunk, section_ptr);
     };
 
-    ParseAction parse_action = ParseAction::NEW_LINE;
+    const auto msg = [&](const std::string& message) -> void
+    {
+        Emit({ParseEvent::Type::MESSAGE, line, character_pos, SymbolTable::invalid_symbol, {}, nullptr, message});
+    };
 
-    uint32_t line = 1u, character_pos = 0u;
-    bool ignore_current_spaces = true;
+    // Source characters are referenced in place when source is retained, everything else goes to arena
+    const auto Store = [this, &strings](const Token& token) -> std::string_view
+    {
+        if (_retain_source && !token.owned())
+            return token.view();
+
+        return strings.store(token.view());
+    };
 
-    const auto GetErrorLineString = [&line, &character_pos]() -> std::string
+    // Section names are mostly unique, they go right to the shared table
+    const auto InternShared = [this](const Token& token) -> std::pair<Symbol, std::string_view>
     {
-        return "Error at line \'" + std::to_string(line) +
-            "\', character at \'" + std::to_string(character_pos) + "\' : ";
+        std::lock_guard<std::mutex> lock(_symbol_mutex);
+
+        const Symbol symbol = _symbols.intern(token.view());
+
+        return {symbol, _symbols.name(symbol)};
     };
 
-    const auto msg = [&GetErrorLineString, this](const std::string& message) -> void
+    // Keys and attributes repeat a lot, shared table is locked only for the ones this chunk has not seen yet
+    const auto Intern = [&chunk, &InternShared](const Token& token) -> Symbol
     {
-        if (_msg_functor)
-            _msg_functor(GetErrorLineString() + message);
+        if (const auto iter = chunk.symbols.find(token.view()); iter != chunk.symbols.cend())
+            return iter->second;
+
+        const auto [symbol, name] = InternShared(token);
+        chunk.symbols.emplace(name, symbol);
+
+        return symbol;
     };
 
     const auto PushInheritance = [&]() -> void
     {
         if (!inheritance.empty() && (section_ptr != nullptr))
         {
-            if (_section_data.find(inheritance) != _section_data.cend())
-                section_ptr->inheritances.push_back(inheritance);
+            if (visitor != nullptr)
+                visitor->onInheritance(inheritance.view());
             else
-                msg("Inherited section \"" + inheritance + "\" is not exist!");
-
-            inheritance.clear();
+            {
+                const auto [symbol, name] = InternShared(inheritance);
+                Emit({ParseEvent::Type::INHERITANCE, line, character_pos, symbol, name, nullptr, {}});
+            }
         }
+
+        inheritance.clear();
     };
 
     const auto PushAttribute = [&]() -> void
     {
         if (!attribute.empty() && (section_ptr != nullptr))
         {
-            section_ptr->attributes.push_back(attribute);
-            attribute.clear();
+            if (visitor != nullptr)
+                visitor->onAttribute(attribute.view());
+            else
+                section_ptr->attributes.push_back(Intern(attribute));
         }
+
+        attribute.clear();
     };
 
     const auto ProcessPreprocessor = [&]() -> void
@@ -279,219 +1643,204 @@ void CFGParser::load(const std::string& file_path)
 
     const auto IncludeFile = [&](const std::string& path) -> void
     {
-        const auto file = _current_file;
-        this->load(_base_path + path);
-        _current_file = file;
+        Emit({ParseEvent::Type::INCLUDE, line, character_pos, SymbolTable::invalid_symbol, {}, nullptr, path});
+    };
+
+    StructuralScanner scanner(begin, end);
+
+    // Literal characters up to the next structural byte are taken as one run
+    const auto TakeRun = [&](const char*& iter) -> std::string_view
+    {
+        const char* const run_end = scanner.next(iter + 1);
+        const std::string_view run(iter, static_cast<size_t>(run_end - iter));
+
+        character_pos += static_cast<uint32_t>(run.size() - 1u);
+        iter = run_end - 1;
+
+        return run;
     };
 
-    while (!file.eof())
+    for (const char* iter = begin; iter != end; ++iter)
     {
-        const auto character = file.get();
+        const char character = *iter;
+
+        // Text-mode streams used to fold CRLF into a single '\n', keep doing that
+        if ((character == '\r') && ((iter + 1) != end) && (*(iter + 1) == '\n'))
+            continue;
 
-        switch (character)
+        const Transition transition = transition_table[static_cast<size_t>(parse_action)]
+            [static_cast<size_t>(character_classes[static_cast<uint8_t>(character)])];
+
+        switch (transition.operation)
         {
-            case comment_character:
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+            case TokenOperation::NONE:
+            break;
 
-                    default:
-                        parse_action = ParseAction::COMMENT;
-                    break;
-                }
+            case TokenOperation::ERROR:
+            {
+                parse_action = ParseAction::ERROR;
+                msg(std::string(parse_messages[static_cast<size_t>(transition.message)]));
             }
             break;
 
-            case comment_multiline:
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+            case TokenOperation::APPEND_CHARACTER:
+                value += std::string_view(iter, 1u);
+            break;
 
-                    case ParseAction::MULTILINE_COMMENT:
-                        parse_action = ParseAction::NEW_LINE;
-                    break;
+            case TokenOperation::SKIP_RUN:
+                TakeRun(iter);
+            break;
 
-                    default:
-                        parse_action = ParseAction::MULTILINE_COMMENT;
-                    break;
-                }
+            case TokenOperation::START_KEY:
+            {
+                parse_action = ParseAction::KEY;
+                key += TakeRun(iter);
             }
             break;
 
-            case ' ':
-            case '\t':
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+            case TokenOperation::APPEND_PREPROCESSOR:
+                preprocessor_pair.first += TakeRun(iter);
+            break;
 
-                    case ParseAction::PREPROCESSOR:
-                    {
-                        if (preprocessor_pair.first == "include")
-                            parse_action = ParseAction::INCLUDE;
+            case TokenOperation::APPEND_INCLUDE:
+                preprocessor_pair.second += TakeRun(iter);
+            break;
 
-                        preprocessor_pair.first.clear();
-                    }
-                    break;
+            case TokenOperation::APPEND_SECTION:
+                section += TakeRun(iter);
+            break;
 
-                    case ParseAction::ATTRIBUTE:
-                    case ParseAction::INHERITANCE:
-                    case ParseAction::KEY:
-                    case ParseAction::SECTION:
-                    case ParseAction::VALUE:
-                    {
-                        if (!ignore_current_spaces)
-                        {
-                            parse_action = ParseAction::ERROR;
-                            msg("Space in wrong place");
-                        }
-                    }
-                    break;
+            case TokenOperation::APPEND_INHERITANCE:
+                inheritance += TakeRun(iter);
+            break;
 
-                    default:
-                    break;
-                }
-            }
+            case TokenOperation::APPEND_ATTRIBUTE:
+                attribute += TakeRun(iter);
             break;
 
-            case '\\':
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+            case TokenOperation::APPEND_KEY:
+                key += TakeRun(iter);
+            break;
 
-                    case ParseAction::STRING_VALUE:
-                    {
-                        switch (file.get())
-                        {
-                            case '\\':
-                                value += '\\';
-                            break;
-
-                            case 'n':
-                                value += '\n';
-                            break;
-
-                            case '\"':
-                                value += '\"';
-                            break;
-
-                            case '\'':
-                                value += '\'';
-                            break;
-
-                            default:
-                                msg("Unknown escape-sequence symbol");
-                            break;
-                        }
-                    }
-                    break;
+            case TokenOperation::APPEND_VALUE:
+                value += TakeRun(iter);
+            break;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Unexpected escape-symbol");
-                    break;
-                }
-            }
+            case TokenOperation::START_COMMENT:
+                parse_action = ParseAction::COMMENT;
+            break;
+
+            case TokenOperation::START_MULTILINE_COMMENT:
+                parse_action = ParseAction::MULTILINE_COMMENT;
+            break;
+
+            case TokenOperation::END_MULTILINE_COMMENT:
+                parse_action = ParseAction::NEW_LINE;
             break;
 
-            case '\"':
+            case TokenOperation::CHECK_SPACE:
             {
-                switch (parse_action)
+                if (!ignore_current_spaces)
                 {
-                    case ParseAction::STRING_VALUE:
-                        parse_action = ParseAction::VALUE;
-                    break;
+                    parse_action = ParseAction::ERROR;
+                    msg(std::string(parse_messages[static_cast<size_t>(transition.message)]));
+                }
+            }
+            break;
 
-                    case ParseAction::VALUE:
-                        parse_action = ParseAction::STRING_VALUE;
-                    break;
+            case TokenOperation::PREPROCESSOR_SPACE:
+            {
+                if (preprocessor_pair.first == "include")
+                    parse_action = ParseAction::INCLUDE;
 
-                    default:
-                    break;
-                }
+                preprocessor_pair.first.clear();
             }
             break;
 
-            case '#':
+            case TokenOperation::ESCAPE:
             {
-                switch (parse_action)
+                switch (((iter + 1) != end) ? *(++iter) : '\0')
                 {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
+                    case '\\':
+                        value.push_back('\\');
                     break;
 
-                    case ParseAction::NEW_LINE:
-                    {
-                        parse_action = ParseAction::PREPROCESSOR;
-                    }
+                    case 'n':
+                        value.push_back('\n');
+                    break;
+
+                    case '\"':
+                        value.push_back('\"');
                     break;
 
-                    case ParseAction::STRING_VALUE:
-                        value += character;
+                    case '\'':
+                        value.push_back('\'');
                     break;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Preprocessor parse error");
+                    default:
+                        msg(std::string(parse_messages[static_cast<size_t>(transition.message)]));
                     break;
                 }
             }
             break;
 
-            case '\n':
+            case TokenOperation::START_STRING:
+                parse_action = ParseAction::STRING_VALUE;
+            break;
+
+            case TokenOperation::END_STRING:
+                parse_action = ParseAction::VALUE;
+            break;
+
+            case TokenOperation::START_PREPROCESSOR:
+                parse_action = ParseAction::PREPROCESSOR;
+            break;
+
+            case TokenOperation::NEW_LINE:
+            case TokenOperation::NEW_LINE_INHERITANCE:
+            case TokenOperation::NEW_LINE_ATTRIBUTE:
+            case TokenOperation::NEW_LINE_VALUE:
+            case TokenOperation::NEW_LINE_ERROR:
             {
-                switch (parse_action)
+                switch (transition.operation)
                 {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
-
-                    case ParseAction::INHERITANCE:
+                    case TokenOperation::NEW_LINE_INHERITANCE:
                         PushInheritance();
                     break;
 
-                    case ParseAction::PREPROCESSOR:
-                    case ParseAction::INCLUDE:
-                    break;
-
-                    case ParseAction::ATTRIBUTE:
+                    case TokenOperation::NEW_LINE_ATTRIBUTE:
                         PushAttribute();
                     break;
 
-                    case ParseAction::VALUE:
-                    case ParseAction::VALUE_ARRAY:
+                    case TokenOperation::NEW_LINE_VALUE:
                     {
-                        if (section_ptr != nullptr)
-                            section_ptr->values[key] = value;
+                        if ((value_ptr != nullptr) && (visitor != nullptr))
+                            visitor->onKeyValue(key.view(), value.view());
+                        else if (value_ptr != nullptr)
+                            *value_ptr = Store(value);
 
+                        value_ptr = nullptr;
                         key.clear();
                         value.clear();
                     }
                     break;
 
-                    case ParseAction::STRING_VALUE:
-                    case ParseAction::NEW_LINE:
+                    case TokenOperation::NEW_LINE_ERROR:
+                    {
+                        parse_action = ParseAction::ERROR;
+                        msg(std::string(parse_messages[static_cast<size_t>(transition.message)]));
+                    }
                     break;
 
-                    case ParseAction::SECTION:
-                        parse_action = ParseAction::NEW_LINE;
+                    default:
                     break;
+                }
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("New line parse error");
-                    break;
+                // Key of a line with error is passed with empty value, load() keeps it so as well
+                if ((parse_action == ParseAction::ERROR) && (value_ptr != nullptr) && (visitor != nullptr))
+                {
+                    visitor->onKeyValue(key.view(), {});
+                    value_ptr = nullptr;
                 }
 
                 if ((parse_action != ParseAction::STRING_VALUE) &&
@@ -506,271 +1855,284 @@ void CFGParser::load(const std::string& file_path)
             }
             break;
 
-            case '<':
+            case TokenOperation::INCLUDE_FILE:
             {
-                switch (parse_action)
-                {
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
-
-                    case ParseAction::INCLUDE:
-                    break;
+                IncludeFile(preprocessor_pair.second);
+                preprocessor_pair.second.clear();
+            }
+            break;
 
-                    default:
-                    break;
-                }
+            case TokenOperation::START_SECTION:
+            {
+                ignore_current_spaces = false;
+                parse_action = ParseAction::SECTION;
+                section.clear();
+                section_ptr = nullptr;
             }
             break;
 
-            case '>':
+            case TokenOperation::END_SECTION:
             {
-                switch (parse_action)
+                if (visitor != nullptr)
                 {
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+                    section_ptr = &stream_section;
+                    visitor->onSection(section.view());
+                }
+                else
+                {
+                    // Sections from other chunks and includes are checked on merge
+                    const auto [symbol, name] = InternShared(section);
 
-                    case ParseAction::INCLUDE:
+                    if (const auto pair = sections.try_emplace(symbol); pair.second)
                     {
-                        IncludeFile(preprocessor_pair.second);
-                        preprocessor_pair.second.clear();
-                    }
-                    break;
+                        section_ptr = pair.first;
+                        section_table = &sections;
 
-                    default:
-                    break;
+                        if (chunk.deferred)
+                            Emit({ParseEvent::Type::SECTION, line, character_pos, symbol, name, section_ptr, {}});
+                    }
+                    else
+                    {
+                        msg("Section \"" + section.str() + "\" already exist.");
+                    }
                 }
+
+                ignore_current_spaces = true;
             }
             break;
 
-            case '[':
+            case TokenOperation::PUSH_INHERITANCE:
+                PushInheritance();
+            break;
+
+            case TokenOperation::PUSH_ATTRIBUTE:
+                PushAttribute();
+            break;
+
+            case TokenOperation::START_ARRAY:
             {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+                parse_action = ParseAction::VALUE_ARRAY;
+                value += std::string_view(iter, 1u);
+            }
+            break;
 
-                    case ParseAction::NEW_LINE:
-                    {
-                        ignore_current_spaces = false;
-                        parse_action = ParseAction::SECTION;
-                        section.clear();
-                        section_ptr = nullptr;
-                    }
-                    break;
+            case TokenOperation::START_INHERITANCE:
+                parse_action = ParseAction::INHERITANCE;
+            break;
 
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+            case TokenOperation::START_ATTRIBUTE:
+                parse_action = ParseAction::ATTRIBUTE;
+            break;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Section naming parse error");
-                    break;
-                }
+            case TokenOperation::END_INHERITANCE:
+            {
+                PushInheritance();
+
+                parse_action = ParseAction::ATTRIBUTE;
             }
             break;
 
-            case ']':
+            case TokenOperation::END_KEY:
             {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+                value_ptr = nullptr;
 
-                    case ParseAction::SECTION:
+                if ((section_ptr != nullptr) && (visitor != nullptr))
+                {
+                    value_ptr = &stream_value;
+                }
+                else if (section_ptr != nullptr)
+                {
+                    // Duplicate key still gets overwritten by the new value
+                    if (const auto pair = section_table->emplaceValue(*section_ptr, Intern(key)); pair.second)
                     {
-                        const auto& pair = _section_data.try_emplace(section, Section{});
-
-                        if (pair.second)
-                            section_ptr = &pair.first->second;
-                        else
-                            msg("Section \"" + section + "\" already exist.");
-
-                        ignore_current_spaces = true;
+                        value_ptr = pair.first;
+                    }
+                    else
+                    {
+                        value_ptr = pair.first;
+                        Emit({ParseEvent::Type::SECTION_MESSAGE, line, character_pos, SymbolTable::invalid_symbol, {}, nullptr,
+                            "Section \"" + section.str() + "\" key \"" + key.str() + "\" already exist."});
                     }
-                    break;
-
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
-
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Section naming parse error");
-                    break;
                 }
+
+                parse_action = ParseAction::VALUE;
             }
             break;
+        }
 
-            case ',':
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+        ++character_pos;
+    }
+}
 
-                    case ParseAction::INHERITANCE:
-                        PushInheritance();
-                    break;
+void CFGParser::mergeChunk(ParseChunk& chunk, Section*& section_ptr)
+{
+    _section_data.reserve(_section_data.size() + chunk.sections.size());
 
-                    case ParseAction::ATTRIBUTE:
-                        PushAttribute();
-                    break;
+    for (const auto& event : chunk.events)
+        this->applyEvent(event, chunk, section_ptr);
 
-                    case ParseAction::STRING_VALUE:
-                    case ParseAction::VALUE_ARRAY:
-                        value += character;
-                    break;
+    _strings.absorb(std::move(chunk.strings));
+}
 
-                    case ParseAction::VALUE:
-                        parse_action = ParseAction::VALUE_ARRAY;
-                        value += character;
-                    break;
+void CFGParser::applyEvent(const ParseEvent& event, const ParseChunk& chunk, Section*& section_ptr)
+{
+    const uint32_t line_offset = chunk.line_offset;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Enumeration error");
-                    break;
-                }
-            }
-            break;
+    const auto msg = [&event, line_offset, this](const std::string& message) -> void
+    {
+        if (_visitor || _msg_functor)
+        {
+            const std::string text = "Error at line \'" + std::to_string(event.line + line_offset) +
+                "\', character at \'" + std::to_string(event.character_pos) + "\' : " + message;
 
-            case ':':
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+            if (_visitor != nullptr)
+                _visitor->onError(text);
+            else
+                _msg_functor(text);
+        }
+    };
 
-                    case ParseAction::SECTION:
-                        parse_action = ParseAction::INHERITANCE;
-                    break;
+    switch (event.type)
+    {
+        case ParseEvent::Type::MESSAGE:
+            msg(event.text);
+        break;
 
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+        // Messages about section which turned out to be a duplicate are dropped
+        case ParseEvent::Type::SECTION_MESSAGE:
+        {
+            if (section_ptr != nullptr)
+                msg(event.text);
+        }
+        break;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Inheritance error");
-                    break;
-                }
+        case ParseEvent::Type::SECTION:
+        {
+            // Values are copied out of chunk's own table
+            if (const auto pair = _section_data.insert(chunk.sections, event.symbol, *event.section); pair.second)
+            {
+                section_ptr = pair.first;
             }
-            break;
-
-            case '=':
+            else
             {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+                section_ptr = nullptr;
+                msg("Section \"" + std::string(event.name) + "\" already exist.");
+            }
+        }
+        break;
 
-                    case ParseAction::SECTION:
-                        parse_action = ParseAction::ATTRIBUTE;
-                    break;
+        case ParseEvent::Type::INHERITANCE:
+        {
+            if (section_ptr != nullptr)
+            {
+                if (_section_data.find(event.symbol) != nullptr)
+                    section_ptr->inheritances.push_back(event.symbol);
+                else
+                    msg("Inherited section \"" + std::string(event.name) + "\" is not exist!");
+            }
+        }
+        break;
 
-                    case ParseAction::INHERITANCE:
-                    {
-                        PushInheritance();
+        case ParseEvent::Type::INCLUDE:
+        {
+            const auto file_path = _base_path + event.text;
+            const auto path = canonicalPath(file_path);
 
-                        parse_action = ParseAction::ATTRIBUTE;
-                    }
-                    break;
+            if (const auto iter = std::find(_include_stack.cbegin(), _include_stack.cend(), path);
+                iter != _include_stack.cend())
+            {
+                std::string cycle;
 
-                    case ParseAction::KEY:
-                    {
-                        if (section_ptr != nullptr)
-                        {
-                            const auto& pair = section_ptr->values.try_emplace(key, std::string {});
+                for (auto cycle_iter = iter; cycle_iter != _include_stack.cend(); ++cycle_iter)
+                    cycle += "\"" + *cycle_iter + "\" -> ";
 
-                            if (!pair.second)
-                                msg("Section \"" + section + "\" key \"" + key + "\" already exist.");
-                        }
+                msg("Include cycle " + cycle + "\"" + path + "\".");
+            }
+            else if ((_included_files.count(path) == 0u) && (_visitor != nullptr))
+            {
+                this->streamFile(file_path);
+            }
+            else if (_included_files.count(path) == 0u)
+            {
+                const auto file = _current_file;
 
-                        parse_action = ParseAction::VALUE;
-                    }
-                    break;
+                if (auto included = this->takePrefetched(path); included != nullptr)
+                {
+                    _current_file = file_path;
 
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+                    if (included->file.isOpen())
+                    {
+                        _included_files.insert(path);
+                        _include_stack.push_back(path);
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Set value error");
-                    break;
-                }
-            }
-            break;
+                        Section* included_section_ptr = nullptr;
+                        this->mergeChunk(included->chunk, included_section_ptr);
 
-            default:
-            {
-                switch (parse_action)
-                {
-                    case ParseAction::COMMENT:
-                    case ParseAction::MULTILINE_COMMENT:
-                    break;
+                        _include_stack.pop_back();
 
-                    case ParseAction::NEW_LINE:
+                        if (_retain_source)
+                            _sources.push_back(std::move(included->file));
+                    }
+                    else if (_msg_functor)
                     {
-                        parse_action = ParseAction::KEY;
-                        key += character;
+                        _msg_functor("Cannot open file \"" + file_path + "\".");
                     }
-                    break;
+                }
+                else
+                {
+                    this->load(file_path);
+                }
 
-                    case ParseAction::PREPROCESSOR:
-                        preprocessor_pair.first += character;
-                    break;
+                _current_file = file;
+            }
+        }
+        break;
+    }
+}
 
-                    case ParseAction::INCLUDE:
-                        preprocessor_pair.second += character;
-                    break;
+void CFGParser::setConcurrent(const bool concurrent)
+{
+    if (concurrent == (_value_shards != nullptr))
+        return;
 
-                    case ParseAction::SECTION:
-                        section += character;
-                    break;
+    if (concurrent)
+    {
+        _value_shards = std::make_unique<ValueShard[]>(size_t {1u} << value_shard_bits);
 
-                    case ParseAction::INHERITANCE:
-                        inheritance += character;
-                    break;
+        while (!_set_texts.empty())
+        {
+            auto node = _set_texts.extract(_set_texts.begin());
+            this->shardOf(node.key()).texts.insert(std::move(node));
+        }
 
-                    case ParseAction::ATTRIBUTE:
-                        attribute += character;
-                    break;
+        return;
+    }
 
-                    case ParseAction::KEY:
-                        key += character;
-                    break;
+    // Buffers change hands as map nodes, values keep pointing to them
+    for (size_t shard = 0u; shard < (size_t {1u} << value_shard_bits); ++shard)
+        _set_texts.merge(_value_shards[shard].texts);
 
-                    case ParseAction::VALUE:
-                    case ParseAction::VALUE_ARRAY:
-                        value += character;
-                    break;
+    _value_shards.reset();
+}
 
-                    case ParseAction::STRING_VALUE:
-                        value += character;
-                    break;
+const bool CFGParser::freeze()
+{
+    if (_frozen != nullptr)
+        return true;
 
-                    default:
-                        parse_action = ParseAction::ERROR;
-                        msg("Invalid character error");
-                    break;
-                }
-            }
-            break;
-        }
+    auto frozen = std::make_unique<FrozenIndex>();
 
-        ++character_pos;
+    if (!frozen->build(_section_data, _symbols))
+    {
+        if (_msg_functor)
+            _msg_functor("Config cannot be frozen, some names have the same hash!");
+
+        return false;
     }
 
-    file.close();
+    _frozen = std::move(frozen);
+
+    return true;
 }
 
 void CFGParser::save(const std::string& file_path)
@@ -779,7 +2141,7 @@ void CFGParser::save(const std::string& file_path)
 
     for (const auto& pair : _section_data)
     {
-        file << '[' << pair.first << ']';
+        file << '[' << _symbols.name(pair.first) << ']';
 
         if (!pair.second.inheritances.empty())
         {
@@ -791,7 +2153,7 @@ void CFGParser::save(const std::string& file_path)
                 if (iter != pair.second.inheritances.cbegin())
                     file << ", ";
 
-                file << (*iter);
+                file << _symbols.name(*iter);
             }
         }
 
@@ -805,14 +2167,14 @@ void CFGParser::save(const std::string& file_path)
                 if (iter != pair.second.attributes.cbegin())
                     file << ", ";
 
-                file << (*iter);
+                file << _symbols.name(*iter);
             }
         }
 
         file << '\n';
 
-        for (const auto& pair : pair.second.values)
-            file << pair.first << " = " << pair.second << '\n';
+        for (const auto& [key, value] : _section_data.values(pair.second))
+            file << _symbols.name(key) << " = " << value.view() << '\n';
 
         file << '\n';
     }
@@ -3,9 +3,26 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <array>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+
+#include "MappedFile.hpp"
+#include "StringArena.hpp"
+#include "SymbolTable.hpp"
+#include "FlatSymbolMap.hpp"
+#include "SectionTable.hpp"
+#include "FrozenIndex.hpp"
+#include "AttributeSet.hpp"
+#include "ValueSlot.hpp"
+#include "ValueConversion.hpp"
 
 
 /**
@@ -24,22 +41,129 @@
 */
 class CFGParser final
 {
+    // Compiled image uses the same value conversions
+    friend class CompiledConfig;
+
 public:
 
-    using ValueHash = std::unordered_map<std::string, std::string>;
+    /**
+        \brief Section names, keys and attributes are interned symbols, see getName().
+        Values are views, either into the retained source or into parser's own arena,
+        kept with their last typed conversion.
+    */
+    using Symbol = SymbolTable::Symbol;
+
+    /**
+        \brief Values as a section sees them, own ones and ones found through inheritance.
+        Point to the values of the sections they come from, so set() shows up in derived sections.
+    */
+    using EffectiveValueHash = SectionTable::EffectiveValueHash;
 
-    struct Section final
+    /**
+        \brief Sections and values live in a few flat arrays, own values of a section
+        are walked with getSectionData().values(section).
+    */
+    using Section = SectionTable::Section;
+    using SectionDataHash = SectionTable;
+
+    /**
+        \brief Resolved section key, see resolve().
+        Points right to the value, reading it takes no hashing and no inheritance walk.
+    */
+    struct Handle final
     {
-        std::vector<std::string> inheritances;
-        std::vector<std::string> attributes;
-        ValueHash values;
+        const ValueSlot* value {nullptr};
+        uint64_t generation {0u};
     };
 
-    using SectionDataHash = std::unordered_map<std::string, Section>;
+    /**
+        \brief Receives config piece by piece, see stream().
+        Views are valid only during the call, section context is the last onSection().
+        Key of a line with error comes after onError() with empty value, the same as load() keeps it.
+    */
+    class Visitor
+    {
+    public:
+        virtual ~Visitor() noexcept = default;
+
+        virtual void onSection(std::string_view /*name*/) {}
+        virtual void onInheritance(std::string_view /*base_section*/) {}
+        virtual void onAttribute(std::string_view /*attribute*/) {}
+        virtual void onKeyValue(std::string_view /*key*/, std::string_view /*value*/) {}
+        virtual void onError(const std::string& /*message*/) {}
+    };
 
 private:
     SectionDataHash _section_data;
 
+    // Perfect hash index of frozen config, see freeze()
+    std::unique_ptr<FrozenIndex> _frozen;
+
+    /**
+        \brief Lock stripe of concurrent mode (see setConcurrent()), values are spread over stripes by address,
+        so values of different sections may share one. Stripe owns set() buffers of its values,
+        writers of different stripes share nothing.
+    */
+    struct alignas(64) ValueShard final
+    {
+        std::shared_mutex mutex;
+        std::unordered_map<const ValueSlot*, std::string> texts;
+    };
+
+    static constexpr uint32_t value_shard_bits {6u};
+    std::unique_ptr<ValueShard[]> _value_shards;
+
+    // Bumped by every load, handles of older generations are stale
+    uint64_t _generation {1u};
+
+    // Attribute bit positions and sections which have every attribute (in symbol order)
+    FlatSymbolMap<uint32_t> _attribute_bits;
+    std::vector<std::vector<Symbol>> _attribute_sections;
+
+    // Sections which inherit every base directly (in symbol order)
+    FlatSymbolMap<std::vector<Symbol>> _derived_sections;
+
+    // Names shared by all sections, workers intern under the lock
+    SymbolTable _symbols;
+    std::mutex _symbol_mutex;
+
+    // Storage for everything which is not referenced right in the source
+    StringArena _strings;
+
+    // Text of values changed by set(), one buffer per value which later sets reuse (own map of every stripe in concurrent mode)
+    std::unordered_map<const ValueSlot*, std::string> _set_texts;
+
+    // Loaded files which parsed data points into (if source is retained)
+    std::vector<MappedFile> _sources;
+    bool _retain_source {false};
+
+    // Converts array value to typed blob in the arena at link time (if typed arrays are on)
+    void (*_typed_array_builder)(ValueSlot&, StringArena&) {nullptr};
+
+    // Parallel parsing, inputs smaller than two chunks are always parsed in one go
+    static constexpr size_t min_chunk_size {256u * 1024u};
+
+    // Streamed input is parsed by windows of at least this size
+    static constexpr size_t stream_window_size {4u * 1024u * 1024u};
+    uint32_t _thread_count {1u};
+
+    struct ParseState;
+    struct ParseEvent;
+    struct ParseChunk;
+
+    // Include graph of current load: every file is merged once, including a file
+    // which is still being parsed is a cycle
+    std::unordered_set<std::string> _included_files;
+    std::vector<std::string> _include_stack;
+
+    // Includes parsed ahead on worker threads, merged in declaration order
+    struct IncludedFile;
+    std::unordered_map<std::string, std::future<std::unique_ptr<IncludedFile>>> _prefetched;
+    std::mutex _prefetch_mutex;
+
+    // Set while streaming, parsed data goes there instead of section table
+    Visitor* _visitor {nullptr};
+
     std::function<void(const std::string&)> _msg_functor;
 
     static constexpr char comment_character {';'};
@@ -49,13 +173,12 @@ private:
     std::string _base_path {};
 
     // Some dummies for return unexistance things
-    const std::vector<std::string> _dummy {};
-    const std::string _dummy_str {};
+    const std::vector<Symbol> _dummy {};
 
 public:
     CFGParser() noexcept;
     CFGParser(const std::string& file_path) noexcept;
-    ~CFGParser() noexcept = default;
+    ~CFGParser() noexcept;
 
     // We cannot copy config file or move it. Sorry)
     CFGParser(CFGParser const&) noexcept = delete;
@@ -73,115 +196,350 @@ public:
     */
     template<typename F> void setMessageFunctor(F&& func) { _msg_functor = std::move(func); }
 
+    /**
+        \brief Zero-copy mode. Loaded file stays in memory and parsed data points right into it,
+        only unescaped (or otherwise non-contiguous) strings get copied.
+        For loadFromMemory() caller has to keep the buffer alive as long as the parser.
+    */
+    void setRetainSource(const bool retain) { _retain_source = retain; }
+
+    /**
+        \brief Number of threads used to parse big files, 0 means all hardware threads.
+        Input is split at section headers and parsed in parallel, included files are parsed
+        side by side. Diagnostics are the same as with one thread.
+    */
+    void setThreadCount(const uint32_t count) { _thread_count = count; }
+
+    /**
+        \brief Array values are converted to T once at load time and kept as contiguous blobs,
+        getArrayView() returns them with no conversion and getArray() just copies them.
+        Only values with several elements which all are T become blobs, others stay text.
+        Has to be set before load, set() turns value back to text.
+    */
+    template<typename T>
+    void setTypedArrays()
+    {
+        static_assert((ValueSlot::typeId<T>() != 0u) && !std::is_same<T, bool>::value, "Typed arrays are numeric only");
+
+        _typed_array_builder = &CFGParser::makeTypedArray<T>;
+    }
+
+    /**
+        \brief Concurrent mode: set() may be called while other threads read. Every value is guarded
+        by the reader/writer lock of one of 64 stripes, which is picked by the value itself (derived sections
+        which read an inherited value take the lock of the base section's value). Values of unrelated sections
+        may share a stripe, so a write can hold up readers of other sections, but only for the copy of the text.
+        Any set() invalidates views returned by getString(), copyString() is the only safe way to read text
+        in this mode (getString() reports such use). Typed reads and handles are safe.
+        Has to be set before the parser is shared between threads, loads and save() are not covered
+        (see SharedConfig for reloads).
+    */
+    void setConcurrent(const bool concurrent);
+    const bool isConcurrent() const noexcept { return _value_shards != nullptr; }
+
     /**
         \brief Load and parse config file.
+        Every file is included once (by canonical path), repeated includes are skipped
+        and include cycles are reported.
+        Inheritance is linked after every load, see getString().
     */
     void load(const std::string& file_path);
+
+    /**
+        \brief Parse config which is already in memory. Includes are resolved against base path.
+        Data is parsed in place, it only has to live until this call returns (unless source is retained).
+    */
+    void loadFromMemory(std::string_view data);
+
+    /**
+        \brief Runs the parser without storing anything, everything found is passed to visitor.
+        Memory use does not depend on config size. Includes are followed, but checks which
+        need the whole config (duplicate sections and keys, unknown base sections) are up to visitor.
+    */
+    void stream(const std::string& file_path, Visitor& visitor);
+    void streamFromMemory(std::string_view data, Visitor& visitor);
+
     void save(const std::string& file_path);
     void saveCurrent() { this->save(_current_file); }
 
+    /**
+        \brief Makes config read-only: section names and keys of every section get minimal perfect
+        hash functions, so a lookup is one hash and one compare per name, whatever the inheritance is.
+        set() and loads are rejected after that. Returns false (and config stays writable)
+        if some names cannot be told apart by their hashes.
+    */
+    const bool freeze();
+    const bool isFrozen() const noexcept { return _frozen != nullptr; }
+
     /**
         \brief Checking that the section have some attributes(string flags).
     */
-    const bool hasAttribute(const std::string& section, const std::string& attribute) const noexcept;
-    const bool hasAttributes(const std::string& section) const noexcept;
-    const std::vector<std::string>& getAttributes(const std::string& section) const noexcept;
+    const bool hasAttribute(std::string_view section, std::string_view attribute) const noexcept;
+    const bool hasAttributes(std::string_view section) const noexcept;
+    const std::vector<Symbol>& getAttributes(std::string_view section) const noexcept;
+
+    /**
+        \brief Sections which have the attribute, all of the attributes or any of them, in symbol order.
+        Answered from attribute index, section table is not scanned. Empty list matches nothing.
+    */
+    const std::vector<Symbol>& getSectionsWithAttribute(std::string_view attribute) const noexcept;
+    std::vector<Symbol> getSectionsWithAllAttributes(const std::vector<std::string_view>& attributes) const;
+    std::vector<Symbol> getSectionsWithAnyAttribute(const std::vector<std::string_view>& attributes) const;
 
     /**
         \brief Checking is section exists.
     */
-    const bool hasSection(const std::string& section) const noexcept;
+    const bool hasSection(std::string_view section) const noexcept;
 
     /**
         \brief Checking is key exist inside a section.
     */
-    const bool hasKey(const std::string& section, const std::string& key) const noexcept;
+    const bool hasKey(std::string_view section, std::string_view key) const noexcept;
 
     /**
         \brief Checking is section has inheritance from some other section.
     */
-    const bool isInheritedFrom(const std::string& section, const std::string& base_section) const noexcept;
-    const bool hasInheritances(const std::string& section) const noexcept;
-    const std::vector<std::string>& getInheritances(const std::string& section) const noexcept;
+    const bool isInheritedFrom(std::string_view section, std::string_view base_section) const noexcept;
+    const bool hasInheritances(std::string_view section) const noexcept;
+    const std::vector<Symbol>& getInheritances(std::string_view section) const noexcept;
+
+    /**
+        \brief Sections which inherit the base directly (in symbol order) or through any number of levels
+        (nearest first, base itself is not included). Answered from reverse inheritance index built on load.
+    */
+    const std::vector<Symbol>& getDerivedSections(std::string_view base_section) const noexcept;
+    std::vector<Symbol> getAllDerivedSections(std::string_view base_section) const;
+
+    /**
+        \brief Name of section, key or attribute symbol and the other way round.
+        Name which never appeared in config has no symbol (SymbolTable::invalid_symbol).
+    */
+    std::string_view getName(const Symbol symbol) const noexcept { return _symbols.name(symbol); }
+    const Symbol getSymbol(std::string_view name) const noexcept { return _symbols.find(name); }
 
     /**
         \brief Get string from config file.
+        Key which section does not have is looked up in its bases depth-first, left to right:
+        [derived] : base0, base1 searches base0, bases of base0 and so on, then base1.
+        First section which has the key wins.
+        Every lookup is one probe of the section's effective values, whatever the hierarchy depth is.
+        View stays valid until the value is set or the parser is destroyed,
+        in concurrent mode use copyString() instead (see setConcurrent()).
+    */
+    std::string_view getString(std::string_view section, std::string_view key, std::string_view default_value = {}) const noexcept;
+
+    /**
+        \brief Looks section key up once, value is then read through the handle.
+        Handle follows set(), but any load makes it stale and it has to be resolved again.
+        Key which is not found resolves to default value.
+    */
+    Handle resolve(std::string_view section, std::string_view key) const noexcept;
+    const bool isValid(const Handle& handle) const noexcept { return handle.generation == _generation; }
+
+    std::string_view getString(const Handle& handle, std::string_view default_value = {}) const noexcept;
+
+    /**
+        \brief Same as getString(), but text is copied while the value is locked.
+        In concurrent mode this is the way to read text which other threads may set.
     */
-    const std::string& getString(const std::string& section, const std::string& key, const std::string& default_value = {}) const noexcept;
+    std::string copyString(std::string_view section, std::string_view key, std::string_view default_value = {}) const;
+    std::string copyString(const Handle& handle, std::string_view default_value = {}) const;
 
     /**
         \brief Parse value to desired type. Important! Do not set type as string!
+        Value which is not a number of that type (or does not fit it) is reported
+        through message functor and default value is returned instead.
     */
     template<typename T>
-    inline const T get(const std::string& section, const std::string& key, const T& default_value = static_cast<T>(0)) const noexcept
+    inline const T get(std::string_view section, std::string_view key, const T& default_value = static_cast<T>(0)) const noexcept
     {
-        const auto& str = this->getString(section, key);
+        const auto value = this->findValue(section, key);
 
-        if (!str.empty())
-            return makeValueFromString<T>(str);
-        else
-            return default_value;
+        if (const auto result = this->readValue<T>(value))
+            return result.value;
+        else if (result.error != ConversionError::MISSING)
+            this->reportConversion(section, key, this->copyText(value), result.error);
+
+        return default_value;
+    }
+
+    template<typename T>
+    inline const T get(const Handle& handle, const T& default_value = static_cast<T>(0)) const noexcept
+    {
+        const auto value = this->isValid(handle) ? handle.value : nullptr;
+
+        if (const auto result = this->readValue<T>(value))
+            return result.value;
+        else if (result.error != ConversionError::MISSING)
+            this->reportConversion({}, {}, this->copyText(value), result.error);
+
+        return default_value;
+    }
+
+    /**
+        \brief Same as get(), but failure is returned instead of being reported.
+        Key which is not found (or has empty value) is ConversionError::MISSING.
+    */
+    template<typename T>
+    inline Conversion<T> tryGet(std::string_view section, std::string_view key) const noexcept
+    {
+        return this->readValue<T>(this->findValue(section, key));
+    }
+
+    template<typename T>
+    inline Conversion<T> tryGet(const Handle& handle) const noexcept
+    {
+        return this->readValue<T>(this->isValid(handle) ? handle.value : nullptr);
     }
 
     template<typename T>
-    inline void set(const std::string& section, const std::string& key, const T value) noexcept
+    inline void set(std::string_view section, std::string_view key, const T value) noexcept
     {
-        if (const auto iter = _section_data.find(section);
-            iter != _section_data.cend())
+        if (_frozen != nullptr)
         {
-            if (iter->second.values.find(key) != iter->second.values.cend())
+            if (_msg_functor)
+                _msg_functor("Config is frozen, section \"" + std::string(section) + "\" key \"" + std::string(key) + "\" cannot be set!");
+
+            return;
+        }
+
+        if (const auto section_data = _section_data.find(_symbols.find(section));
+            section_data != nullptr)
+        {
+            if (const auto value_slot = _section_data.findValue(*section_data, _symbols.find(key));
+                value_slot != nullptr)
             {
-                iter->second.values[key] = std::to_string(value);
+                const auto text = std::to_string(value);
+
+                if (_value_shards != nullptr)
+                {
+                    ValueShard& shard = this->shardOf(value_slot);
+                    const std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+                    assignText(shard.texts, *value_slot, text);
+                }
+                else
+                {
+                    assignText(_set_texts, *value_slot, text);
+                }
             }
             else
             {
                 if (_msg_functor)
-                    _msg_functor("Section \"" + section + "\" key \"" + key + "\" is not exist!");
+                    _msg_functor("Section \"" + std::string(section) + "\" key \"" + std::string(key) + "\" is not exist!");
             }
         }
         else
         {
             if (_msg_functor)
-                _msg_functor("Section \"" + section + "\" is not exist!");
+                _msg_functor("Section \"" + std::string(section) + "\" is not exist!");
         }
     }
 
     /**
         \brief Get array value.
+        Element which cannot be converted is zero, the first such element is reported.
+    */
+    template<typename T>
+    inline const std::vector<T> getArray(std::string_view section, std::string_view key) const noexcept
+    {
+        const auto value = this->findValue(section, key);
+
+        if (value == nullptr)
+            return {};
+
+        auto error = ConversionError::NONE;
+        std::vector<T> result;
+        std::string failed_text;
+
+        {
+            const auto lock = this->lockValue(value);
+
+            if (std::span<const T> elements; value->getArray(elements))
+                return std::vector<T>(elements.begin(), elements.end());
+
+            result = makeArrayFromString<T>(value->view(), error);
+
+            // Reported after the lock is released, text may be set again by then
+            if (error != ConversionError::NONE)
+                failed_text = value->view();
+        }
+
+        if (error != ConversionError::NONE)
+            this->reportConversion(section, key, failed_text, error);
+
+        return result;
+    }
+
+    /**
+        \brief Get array value into caller's storage, nothing is allocated.
+        Elements which do not fit are left out (result tells about overflow),
+        element which cannot be converted is zero, the first such element is reported.
     */
     template<typename T>
-    inline const std::vector<T> getArray(const std::string& section, const std::string& key) const noexcept
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, T* const values, const size_t capacity) const noexcept
     {
-        const auto& str = this->getString(section, key);
+        const auto value = this->findValue(section, key);
+
+        if (value == nullptr)
+            return {};
+
+        ArrayConversion result;
+        std::string failed_text;
 
-        if (!str.empty())
         {
-            std::vector<T> result;
-            std::string num_str;
-            const size_t str_len = str.length();
+            const auto lock = this->lockValue(value);
 
-            for (const auto character :  str)
+            if (std::span<const T> elements; value->getArray(elements))
             {
-                if (character == ',')
-                {
-                    result.push_back(makeValueFromString<T>(num_str));
-                    num_str.clear();
-                }
-                else
-                {
-                    num_str += character;
-                }
+                result.count = std::min(elements.size(), capacity);
+                result.overflow = elements.size() > capacity;
+
+                std::copy_n(elements.data(), result.count, values);
+
+                return result;
             }
 
-            // push last element
-            result.push_back(makeValueFromString<T>(num_str));
+            result = convertArray<T>(value->view(), values, capacity);
 
-            return result;
+            if (result.error != ConversionError::NONE)
+                failed_text = value->view();
         }
-        else
+
+        if (result.error != ConversionError::NONE)
+            this->reportConversion(section, key, failed_text, result.error);
+
+        return result;
+    }
+
+    template<typename T, size_t N>
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, std::array<T, N>& values) const noexcept
+    {
+        return this->getArray<T>(section, key, values.data(), N);
+    }
+
+    template<typename T>
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, std::span<T> values) const noexcept
+    {
+        return this->getArray<T>(section, key, values.data(), values.size());
+    }
+
+    /**
+        \brief Typed array made at load time (see setTypedArrays()), empty if value has no blob of T.
+        View stays valid until the value is set or the parser is destroyed.
+    */
+    template<typename T>
+    inline std::span<const T> getArrayView(std::string_view section, std::string_view key) const noexcept
+    {
+        std::span<const T> result;
+
+        if (const auto value = this->findValue(section, key); value != nullptr)
         {
-            return {};
+            const auto lock = this->lockValue(value);
+            value->getArray(result);
         }
+
+        return result;
     }
 
     /**
@@ -196,52 +554,172 @@ public:
 
 private:
     template<typename T>
-    inline constexpr T makeValueFromString(const std::string& string_value) const
+    static inline const std::vector<T> makeArrayFromString(const std::string_view str, ConversionError& error)
     {
-        T value = static_cast<T>(0);
+        // Sized once, elements are converted right into it
+        std::vector<T> result(countArrayElements(str));
 
         if constexpr (std::is_same<T, bool>::value)
         {
-            if (string_value == "true" || string_value == "on" || string_value == "yes")
-                value = true;
-        }
-        else if constexpr (std::is_same<T, int>::value)
-        {
-            value = std::stoi(string_value);
-        }
-        else if constexpr (std::is_same<T, uint32_t>::value)
-        {
-            value = std::stoul(string_value);
-        }
-        else if constexpr (std::is_same<T, float>::value)
-        {
-            value = std::stof(string_value);
-        }
-        else if constexpr (std::is_same<T, double>::value)
-        {
-            value = std::stod(string_value);
-        }
-        else if constexpr (std::is_same<T, long double>::value)
-        {
-            value = std::stold(string_value);
-        }
-        else if constexpr (std::is_same<T, int64_t>::value)
-        {
-            value = std::stoll(string_value);
-        }
-        else if constexpr (std::is_same<T, uint64_t>::value)
-        {
-            value = std::stoull(string_value);
+            // Packed vector has no element storage to convert into
+            bool element = false;
+            size_t begin = 0u;
+
+            for (size_t index = 0u; index < result.size(); ++index)
+            {
+                const size_t comma = str.find(',', begin);
+
+                convertArray<bool>(str.substr(begin, comma - begin), &element, 1u);
+                result[index] = element;
+                begin = comma + 1u;
+            }
+
+            error = ConversionError::NONE;
         }
         else
         {
-            value = static_cast<T>(std::stoi(string_value));
+            error = convertArray<T>(str, result.data(), result.size()).error;
         }
 
-        return value;
+        return result;
+    }
+
+    /**
+        \brief Stores array value as typed blob, value which is not an array of T is left alone.
+    */
+    template<typename T>
+    static void makeTypedArray(ValueSlot& value, StringArena& storage)
+    {
+        // Checked first, so lists of strings do not take any arena memory
+        const auto text = value.view();
+
+        if (!convertValue<T>(text.substr(0u, text.find(','))))
+            return;
+
+        const size_t count = countArrayElements(text);
+        auto blob = static_cast<uint64_t*>(storage.allocate(sizeof(uint64_t) + (count * sizeof(T)), alignof(uint64_t)));
+        blob[0] = count;
+
+        if (convertArray<T>(text, reinterpret_cast<T*>(blob + 1), count).error == ConversionError::NONE)
+            value.setArray<T>(blob);
+    }
+
+    const ValueSlot* findValue(std::string_view section, std::string_view key) const noexcept;
+
+    /**
+        \brief Text copied under the value's lock, for reports made after the lock is released
+        (value may be set by another thread in between, report shows the newer text then).
+    */
+    std::string copyText(const ValueSlot* const value) const;
+
+    /**
+        \brief Writes text into the value's own set() buffer, which is reused while the text fits.
+    */
+    static void assignText(std::unordered_map<const ValueSlot*, std::string>& texts, ValueSlot& value, std::string_view text)
+    {
+        std::string& buffer = texts[&value];
+
+        buffer.assign(text.data(), text.size());
+        value = std::string_view(buffer);
+    }
+
+    ValueShard& shardOf(const ValueSlot* const value) const noexcept
+    {
+        const uint64_t address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+
+        return _value_shards[(address * 0x9E3779B97F4A7C15ull) >> (64u - value_shard_bits)];
+    }
+
+    /**
+        \brief Shared lock of the value's stripe in concurrent mode, empty lock otherwise.
+    */
+    std::shared_lock<std::shared_mutex> lockValue(const ValueSlot* const value) const noexcept
+    {
+        if (_value_shards == nullptr)
+            return {};
+
+        return std::shared_lock<std::shared_mutex>(this->shardOf(value).mutex);
+    }
+
+    /**
+        \brief Typed value read under the value's lock. Missing or empty value is ConversionError::MISSING.
+    */
+    template<typename T>
+    inline Conversion<T> readValue(const ValueSlot* const value) const noexcept
+    {
+        const auto Read = [value]() -> Conversion<T>
+        {
+            if (value->empty())
+                return {T {}, ConversionError::MISSING};
+
+            return getTypedValue<T>(*value);
+        };
+
+        if (value == nullptr)
+            return {T {}, ConversionError::MISSING};
+
+        // Lock object is not made at all in the usual mode, handle reads are that cheap
+        if (_value_shards == nullptr)
+            return Read();
+
+        const std::shared_lock<std::shared_mutex> lock(this->shardOf(value).mutex);
+
+        return Read();
+    }
+
+    /**
+        \brief Typed value, converted once and then taken from the slot until the value is set again.
+    */
+    template<typename T>
+    static inline Conversion<T> getTypedValue(const ValueSlot& value) noexcept
+    {
+        Conversion<T> result;
+
+        if (value.getCached(result.value))
+            return result;
+
+        // Failed conversion is not cached, default value may differ from call to call
+        result = convertValue<T>(value.view());
+
+        if (result)
+            value.setCached(result.value);
+
+        return result;
     }
 
-    const std::string& getValueFromInheritance(const Section& section_data, const std::string& key) const noexcept;
+    /**
+        \brief Reports value which cannot be converted, section and key are empty for handles.
+    */
+    void reportConversion(std::string_view section, std::string_view key, std::string_view value, const ConversionError error) const noexcept;
+
+    /**
+        \brief Builds effective values, attribute index and reverse inheritance index,
+        inheritance cycles are reported and cut.
+    */
+    void link();
+
+    /**
+        \brief Runs the config grammar over a contiguous character range.
+    */
+    void parse(const char* const begin, const char* const end);
+    void parseChunk(const char* const begin, const char* const end, ParseState& state, ParseChunk& chunk);
+    void mergeChunk(ParseChunk& chunk, Section*& section_ptr);
+    void applyEvent(const ParseEvent& event, const ParseChunk& chunk, Section*& section_ptr);
+
+    const uint32_t getThreadCount() const noexcept;
+
+    void streamFile(const std::string& file_path);
+    void streamRange(const char* const begin, const char* const end, MappedFile* const file = nullptr);
+    void runStream(Visitor& visitor, const std::function<void()>& body);
+
+    /**
+        \brief Starts parsing of included files on worker threads.
+        Paths are only a guess, include which is never merged is just dropped.
+    */
+    void prefetchIncludes(const char* const begin, const char* const end);
+    void prefetchInclude(const std::string& file_path);
+    std::unique_ptr<IncludedFile> takePrefetched(const std::string& path);
+    void dropPrefetched();
 
 };
 
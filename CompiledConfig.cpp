@@ -0,0 +1,462 @@
+#include "CompiledConfig.hpp"
+#include <array>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <chrono>
+#include <unordered_map>
+#include <cstring>
+
+/**
+    \brief Image layout, every table is 8-byte aligned:
+    Header | SectionRecord[sections] | uint32_t[section slots] | ValueRecord[values] |
+    uint32_t[value slots] | uint32_t[inheritances] | StringRef[attributes] | strings
+    Slots hold record index + 1, zero is an empty slot.
+*/
+struct CompiledConfig::Header final
+{
+    std::array<char, 8u> magic;
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+
+    uint32_t section_count;
+    uint32_t section_slot_count;
+    uint32_t value_count;
+    uint32_t value_slot_count;
+    uint32_t inheritance_count;
+    uint32_t attribute_count;
+
+    uint64_t sections_offset;
+    uint64_t section_slots_offset;
+    uint64_t values_offset;
+    uint64_t value_slots_offset;
+    uint64_t inheritances_offset;
+    uint64_t attributes_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+struct CompiledConfig::StringRef final
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct CompiledConfig::SectionRecord final
+{
+    uint64_t hash;
+    StringRef name;
+
+    uint32_t first_inheritance, inheritance_count;
+    uint32_t first_attribute, attribute_count;
+
+    // Effective values, own ones first and then the inherited ones in lookup order
+    uint32_t first_value, value_count, own_value_count;
+
+    // Own open addressing table of values, slot count is a power of two
+    uint32_t first_value_slot, value_slot_count;
+};
+
+struct CompiledConfig::ValueRecord final
+{
+    uint64_t hash;
+    StringRef key;
+    StringRef value;
+};
+
+static constexpr std::array<char, 8u> image_magic {'C', 'F', 'G', 'I', 'M', 'A', 'G', 'E'};
+static constexpr uint32_t image_byte_order {0x01020304u};
+
+static constexpr uint32_t empty_slot {0u};
+
+static inline uint32_t slotCountFor(const size_t count)
+{
+    uint32_t slot_count = 1u;
+
+    // At most half full
+    while (slot_count < count * 2u)
+        slot_count <<= 1u;
+
+    return slot_count;
+}
+
+static inline uint64_t alignOffset(const uint64_t offset)
+{
+    return (offset + 7u) & ~static_cast<uint64_t>(7u);
+}
+
+const uint64_t CompiledConfig::hash(std::string_view string) noexcept
+{
+    // FNV-1a, hashes are stored in the image so it has to be the same everywhere
+    uint64_t result = 14695981039346656037ull;
+
+    for (const auto character : string)
+    {
+        result ^= static_cast<uint8_t>(character);
+        result *= 1099511628211ull;
+    }
+
+    return result;
+}
+
+const bool CompiledConfig::compile(const CFGParser& parser, const std::string& file_path)
+{
+    static_assert(sizeof(Header) % 8u == 0u, "Image header breaks table alignment");
+    static_assert(sizeof(SectionRecord) == 56u, "Section record layout changed");
+    static_assert(sizeof(ValueRecord) == 24u, "Value record layout changed");
+
+    const auto& section_data = parser.getSectionData();
+
+    std::vector<SectionRecord> sections;
+    std::vector<uint32_t> section_slots(slotCountFor(section_data.size()), empty_slot);
+    std::vector<ValueRecord> values;
+    std::vector<uint32_t> value_slots;
+    std::vector<uint32_t> inheritances;
+    std::vector<StringRef> attributes;
+    std::string strings;
+
+    // Same strings are stored once
+    std::unordered_map<std::string_view, StringRef> string_refs;
+    std::unordered_map<CFGParser::Symbol, uint32_t> section_indices;
+
+    sections.reserve(section_data.size());
+    section_indices.reserve(section_data.size());
+
+    const auto AddString = [&](std::string_view string) -> StringRef
+    {
+        if (const auto iter = string_refs.find(string); iter != string_refs.cend())
+            return iter->second;
+
+        const StringRef ref {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(string.size())};
+        strings += string;
+        string_refs.emplace(string, ref);
+
+        return ref;
+    };
+
+    for (const auto& pair : section_data)
+        section_indices.emplace(pair.first, static_cast<uint32_t>(section_indices.size()));
+
+    for (const auto& pair : section_data)
+    {
+        const auto& section = pair.second;
+        SectionRecord& record = sections.emplace_back();
+
+        const std::string_view name = parser.getName(pair.first);
+
+        record.hash = hash(name);
+        record.name = AddString(name);
+
+        record.first_inheritance = static_cast<uint32_t>(inheritances.size());
+
+        for (const auto& inheritance : section.inheritances)
+        {
+            if (const auto iter = section_indices.find(inheritance); iter != section_indices.cend())
+                inheritances.push_back(iter->second);
+        }
+
+        record.inheritance_count = static_cast<uint32_t>(inheritances.size()) - record.first_inheritance;
+
+        record.first_attribute = static_cast<uint32_t>(attributes.size());
+
+        for (const auto& attribute : section.attributes)
+            attributes.push_back(AddString(parser.getName(attribute)));
+
+        record.attribute_count = static_cast<uint32_t>(section.attributes.size());
+
+        // Inheritance is resolved already, so derived lookups are one probe as in CFGParser
+        const size_t value_count = section.inheritances.empty() ? section.valueCount() : section.effective_values.size();
+
+        record.first_value = static_cast<uint32_t>(values.size());
+        record.value_count = static_cast<uint32_t>(value_count);
+        record.own_value_count = static_cast<uint32_t>(section.valueCount());
+        record.first_value_slot = static_cast<uint32_t>(value_slots.size());
+        record.value_slot_count = (value_count == 0u) ? 0u : slotCountFor(value_count);
+
+        value_slots.resize(value_slots.size() + record.value_slot_count, empty_slot);
+
+        const auto AddValue = [&](const CFGParser::Symbol key_symbol, std::string_view value) -> void
+        {
+            const std::string_view key = parser.getName(key_symbol);
+            const uint64_t key_hash = hash(key);
+            uint32_t slot = static_cast<uint32_t>(key_hash) & (record.value_slot_count - 1u);
+
+            while (value_slots[record.first_value_slot + slot] != empty_slot)
+                slot = (slot + 1u) & (record.value_slot_count - 1u);
+
+            values.push_back(ValueRecord {key_hash, AddString(key), AddString(value)});
+            value_slots[record.first_value_slot + slot] = static_cast<uint32_t>(values.size()) - record.first_value;
+        };
+
+        for (const auto& [key, value] : section_data.values(section))
+            AddValue(key, value);
+
+        for (const auto& [key, value] : section.effective_values)
+        {
+            if (section_data.findValue(section, key) == nullptr)
+                AddValue(key, *value);
+        }
+
+        uint32_t slot = static_cast<uint32_t>(record.hash) & (static_cast<uint32_t>(section_slots.size()) - 1u);
+
+        while (section_slots[slot] != empty_slot)
+            slot = (slot + 1u) & (static_cast<uint32_t>(section_slots.size()) - 1u);
+
+        section_slots[slot] = static_cast<uint32_t>(sections.size());
+
+        // String references are 32-bit
+        if (strings.size() > UINT32_MAX)
+            return false;
+    }
+
+    Header header {};
+    header.magic = image_magic;
+    header.version = format_version;
+    header.byte_order = image_byte_order;
+
+    header.section_count = static_cast<uint32_t>(sections.size());
+    header.section_slot_count = static_cast<uint32_t>(section_slots.size());
+    header.value_count = static_cast<uint32_t>(values.size());
+    header.value_slot_count = static_cast<uint32_t>(value_slots.size());
+    header.inheritance_count = static_cast<uint32_t>(inheritances.size());
+    header.attribute_count = static_cast<uint32_t>(attributes.size());
+
+    header.sections_offset = alignOffset(sizeof(Header));
+    header.section_slots_offset = alignOffset(header.sections_offset + sections.size() * sizeof(SectionRecord));
+    header.values_offset = alignOffset(header.section_slots_offset + section_slots.size() * sizeof(uint32_t));
+    header.value_slots_offset = alignOffset(header.values_offset + values.size() * sizeof(ValueRecord));
+    header.inheritances_offset = alignOffset(header.value_slots_offset + value_slots.size() * sizeof(uint32_t));
+    header.attributes_offset = alignOffset(header.inheritances_offset + inheritances.size() * sizeof(uint32_t));
+    header.strings_offset = alignOffset(header.attributes_offset + attributes.size() * sizeof(StringRef));
+    header.strings_size = strings.size();
+    header.file_size = header.strings_offset + header.strings_size;
+
+    std::vector<char> image(static_cast<size_t>(header.file_size), '\0');
+
+    const auto Write = [&image](const uint64_t offset, const void* data, const size_t size) -> void
+    {
+        if (size != 0u)
+            std::memcpy(image.data() + offset, data, size);
+    };
+
+    Write(0u, &header, sizeof(Header));
+    Write(header.sections_offset, sections.data(), sections.size() * sizeof(SectionRecord));
+    Write(header.section_slots_offset, section_slots.data(), section_slots.size() * sizeof(uint32_t));
+    Write(header.values_offset, values.data(), values.size() * sizeof(ValueRecord));
+    Write(header.value_slots_offset, value_slots.data(), value_slots.size() * sizeof(uint32_t));
+    Write(header.inheritances_offset, inheritances.data(), inheritances.size() * sizeof(uint32_t));
+    Write(header.attributes_offset, attributes.data(), attributes.size() * sizeof(StringRef));
+    Write(header.strings_offset, strings.data(), strings.size());
+
+    // Never rewrite image in place, somebody may have it mapped.
+    // Temporary file is unique, images compiled side by side never share one
+    std::random_device random;
+    const uint64_t unique = ((static_cast<uint64_t>(random()) << 32u) | random()) ^
+        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string temporary_path = file_path + ".tmp." + std::to_string(unique);
+
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    file.close();
+
+    // Failed write is noticed on close too, when buffered data is flushed
+    const bool written = !file.fail();
+    std::error_code error;
+
+    if (written)
+        std::filesystem::rename(temporary_path, file_path, error);
+
+    if (!written || error)
+    {
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+const bool CompiledConfig::load(const std::string& file_path)
+{
+    _header = nullptr;
+
+    if (!_file.open(file_path) || (_file.size() < sizeof(Header)))
+        return false;
+
+    const char* const image = _file.data();
+    const Header* const header = reinterpret_cast<const Header*>(image);
+
+    if ((header->magic != image_magic) || (header->version != format_version) ||
+        (header->byte_order != image_byte_order) || (header->file_size != _file.size()))
+        return false;
+
+    // Only table bounds are checked here, loading must not touch the whole image
+    const auto TableFits = [header](const uint64_t offset, const uint64_t count, const uint64_t item_size) -> bool
+    {
+        return ((offset % 8u) == 0u) && (offset <= header->file_size) &&
+            (count <= ((header->file_size - offset) / item_size));
+    };
+
+    if (!TableFits(header->sections_offset, header->section_count, sizeof(SectionRecord)) ||
+        !TableFits(header->section_slots_offset, header->section_slot_count, sizeof(uint32_t)) ||
+        !TableFits(header->values_offset, header->value_count, sizeof(ValueRecord)) ||
+        !TableFits(header->value_slots_offset, header->value_slot_count, sizeof(uint32_t)) ||
+        !TableFits(header->inheritances_offset, header->inheritance_count, sizeof(uint32_t)) ||
+        !TableFits(header->attributes_offset, header->attribute_count, sizeof(StringRef)) ||
+        !TableFits(header->strings_offset, header->strings_size, 1u) ||
+        (header->section_slot_count == 0u) || ((header->section_slot_count & (header->section_slot_count - 1u)) != 0u))
+        return false;
+
+    _sections = reinterpret_cast<const SectionRecord*>(image + header->sections_offset);
+    _section_slots = reinterpret_cast<const uint32_t*>(image + header->section_slots_offset);
+    _values = reinterpret_cast<const ValueRecord*>(image + header->values_offset);
+    _value_slots = reinterpret_cast<const uint32_t*>(image + header->value_slots_offset);
+    _inheritances = reinterpret_cast<const uint32_t*>(image + header->inheritances_offset);
+    _attributes = reinterpret_cast<const StringRef*>(image + header->attributes_offset);
+    _strings = image + header->strings_offset;
+    _header = header;
+
+    return true;
+}
+
+std::string_view CompiledConfig::getStringRef(const StringRef& ref) const noexcept
+{
+    if ((static_cast<uint64_t>(ref.offset) + ref.size) > _header->strings_size)
+        return {};
+
+    return std::string_view(_strings + ref.offset, ref.size);
+}
+
+const CompiledConfig::SectionRecord* CompiledConfig::findSection(std::string_view section) const noexcept
+{
+    if (_header == nullptr)
+        return nullptr;
+
+    const uint64_t section_hash = hash(section);
+    const uint32_t mask = _header->section_slot_count - 1u;
+
+    for (uint32_t slot = static_cast<uint32_t>(section_hash) & mask, probe = 0u;
+        probe <= mask; slot = (slot + 1u) & mask, ++probe)
+    {
+        const uint32_t index = _section_slots[slot];
+
+        if ((index == empty_slot) || (index > _header->section_count))
+            return nullptr;
+
+        const SectionRecord& record = _sections[index - 1u];
+
+        if ((record.hash == section_hash) && (this->getStringRef(record.name) == section))
+            return &record;
+    }
+
+    return nullptr;
+}
+
+const CompiledConfig::ValueRecord* CompiledConfig::findValue(const SectionRecord& section, std::string_view key, const uint64_t key_hash) const noexcept
+{
+    const uint32_t mask = section.value_slot_count - 1u;
+
+    if ((section.value_slot_count == 0u) ||
+        ((static_cast<uint64_t>(section.first_value_slot) + section.value_slot_count) > _header->value_slot_count) ||
+        ((static_cast<uint64_t>(section.first_value) + section.value_count) > _header->value_count))
+        return nullptr;
+
+    for (uint32_t slot = static_cast<uint32_t>(key_hash) & mask, probe = 0u;
+        probe <= mask; slot = (slot + 1u) & mask, ++probe)
+    {
+        const uint32_t index = _value_slots[section.first_value_slot + slot];
+
+        if ((index == empty_slot) || (index > section.value_count))
+            return nullptr;
+
+        const ValueRecord& record = _values[section.first_value + index - 1u];
+
+        if ((record.hash == key_hash) && (this->getStringRef(record.key) == key))
+            return &record;
+    }
+
+    return nullptr;
+}
+
+const bool CompiledConfig::hasSection(std::string_view section) const noexcept
+{
+    return (this->findSection(section) != nullptr);
+}
+
+const bool CompiledConfig::hasKey(std::string_view section, std::string_view key) const noexcept
+{
+    if (const auto record = this->findSection(section); record != nullptr)
+    {
+        // Inherited values are not section's keys
+        if (const auto value = this->findValue(*record, key, hash(key)); value != nullptr)
+            return (static_cast<uint64_t>(value - (_values + record->first_value)) < record->own_value_count);
+    }
+
+    return false;
+}
+
+const bool CompiledConfig::hasAttribute(std::string_view section, std::string_view attribute) const noexcept
+{
+    if (const auto record = this->findSection(section);
+        (record != nullptr) && ((static_cast<uint64_t>(record->first_attribute) + record->attribute_count) <= _header->attribute_count))
+    {
+        for (uint32_t index = 0u; index < record->attribute_count; ++index)
+        {
+            if (this->getStringRef(_attributes[record->first_attribute + index]) == attribute)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+const bool CompiledConfig::hasAttributes(std::string_view section) const noexcept
+{
+    if (const auto record = this->findSection(section); record != nullptr)
+        return (record->attribute_count != 0u);
+
+    return false;
+}
+
+const bool CompiledConfig::isInheritedFrom(std::string_view section, std::string_view base_section) const noexcept
+{
+    if (const auto record = this->findSection(section);
+        (record != nullptr) && ((static_cast<uint64_t>(record->first_inheritance) + record->inheritance_count) <= _header->inheritance_count))
+    {
+        for (uint32_t index = 0u; index < record->inheritance_count; ++index)
+        {
+            const uint32_t base_index = _inheritances[record->first_inheritance + index];
+
+            if ((base_index < _header->section_count) && (this->getStringRef(_sections[base_index].name) == base_section))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+const bool CompiledConfig::hasInheritances(std::string_view section) const noexcept
+{
+    if (const auto record = this->findSection(section); record != nullptr)
+        return (record->inheritance_count != 0u);
+
+    return false;
+}
+
+std::string_view CompiledConfig::getString(std::string_view section, std::string_view key, std::string_view default_value) const noexcept
+{
+    const auto record = this->findSection(section);
+
+    if (record == nullptr)
+        return default_value;
+
+    if (const auto value = this->findValue(*record, key, hash(key)); value != nullptr)
+        return this->getStringRef(value->value);
+
+    return default_value;
+}
+
+const size_t CompiledConfig::getSectionCount() const noexcept
+{
+    return (_header != nullptr) ? _header->section_count : 0u;
+}
@@ -0,0 +1,130 @@
+#ifndef _COMPILED_CONFIG_HPP_
+#define _COMPILED_CONFIG_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "CFGParser.hpp"
+#include "MappedFile.hpp"
+
+
+/**
+    \brief Parsed config stored as a binary image.
+    Image is written once by compile() and then mapped as is, lookups go right
+    into the mapping through precomputed hash tables, nothing is deserialized.
+    All references inside of the image are offsets, so it may be mapped anywhere.
+*/
+class CompiledConfig final
+{
+public:
+    static constexpr uint32_t format_version {2u};
+
+private:
+    struct Header;
+    struct StringRef;
+    struct SectionRecord;
+    struct ValueRecord;
+
+    MappedFile _file;
+
+    const Header* _header {nullptr};
+    const SectionRecord* _sections {nullptr};
+    const uint32_t* _section_slots {nullptr};
+    const ValueRecord* _values {nullptr};
+    const uint32_t* _value_slots {nullptr};
+    const uint32_t* _inheritances {nullptr};
+    const StringRef* _attributes {nullptr};
+    const char* _strings {nullptr};
+
+public:
+    CompiledConfig() noexcept = default;
+    CompiledConfig(const std::string& file_path) { this->load(file_path); }
+    ~CompiledConfig() noexcept = default;
+
+    CompiledConfig(CompiledConfig const&) = delete;
+    CompiledConfig& operator=(CompiledConfig const&) = delete;
+
+    /**
+        \brief Writes parsed config as binary image. File is replaced atomically,
+        so processes which still have the old image mapped keep working.
+    */
+    static const bool compile(const CFGParser& parser, const std::string& file_path);
+
+    /**
+        \brief Maps binary image. Returns false if file cannot be opened, is damaged
+        or was written by other format version (or on machine with other byte order).
+    */
+    const bool load(const std::string& file_path);
+    const bool isLoaded() const noexcept { return _header != nullptr; }
+
+    const bool hasSection(std::string_view section) const noexcept;
+    const bool hasKey(std::string_view section, std::string_view key) const noexcept;
+
+    const bool hasAttribute(std::string_view section, std::string_view attribute) const noexcept;
+    const bool hasAttributes(std::string_view section) const noexcept;
+
+    const bool isInheritedFrom(std::string_view section, std::string_view base_section) const noexcept;
+    const bool hasInheritances(std::string_view section) const noexcept;
+
+    /**
+        \brief Same lookup as CFGParser::getString(), view points into the mapping.
+    */
+    std::string_view getString(std::string_view section, std::string_view key, std::string_view default_value = {}) const noexcept;
+
+    /**
+        \brief Same conversion as CFGParser::get(), value which cannot be converted gives default value.
+    */
+    template<typename T>
+    inline const T get(std::string_view section, std::string_view key, const T& default_value = static_cast<T>(0)) const noexcept
+    {
+        if (const auto str = this->getString(section, key); !str.empty())
+        {
+            if (const auto result = convertValue<T>(str))
+                return result.value;
+        }
+
+        return default_value;
+    }
+
+    template<typename T>
+    inline const std::vector<T> getArray(std::string_view section, std::string_view key) const noexcept
+    {
+        auto error = ConversionError::NONE;
+
+        return CFGParser::makeArrayFromString<T>(this->getString(section, key), error);
+    }
+
+    /**
+        \brief Same as CFGParser::getArray() into caller's storage, nothing is allocated.
+    */
+    template<typename T>
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, T* const values, const size_t capacity) const noexcept
+    {
+        return convertArray<T>(this->getString(section, key), values, capacity);
+    }
+
+    template<typename T, size_t N>
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, std::array<T, N>& values) const noexcept
+    {
+        return this->getArray<T>(section, key, values.data(), N);
+    }
+
+    template<typename T>
+    inline ArrayConversion getArray(std::string_view section, std::string_view key, std::span<T> values) const noexcept
+    {
+        return this->getArray<T>(section, key, values.data(), values.size());
+    }
+
+    const size_t getSectionCount() const noexcept;
+
+private:
+    static const uint64_t hash(std::string_view string) noexcept;
+
+    std::string_view getStringRef(const StringRef& ref) const noexcept;
+    const SectionRecord* findSection(std::string_view section) const noexcept;
+    const ValueRecord* findValue(const SectionRecord& section, std::string_view key, const uint64_t key_hash) const noexcept;
+};
+
+#endif
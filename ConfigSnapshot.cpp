@@ -0,0 +1,27 @@
+#include "ConfigSnapshot.hpp"
+
+std::shared_ptr<const ConfigSnapshot> ConfigSnapshot::make(std::unique_ptr<CFGParser> parser)
+{
+    parser->freeze();
+
+    return std::shared_ptr<const ConfigSnapshot>(new ConfigSnapshot(std::move(parser)));
+}
+
+const bool SharedConfig::reload(const std::string& file_path)
+{
+    std::lock_guard<std::mutex> lock(_reload_mutex);
+
+    auto parser = std::make_unique<CFGParser>();
+
+    if (_setup)
+        _setup(*parser);
+
+    parser->load(file_path);
+
+    if (parser->getSectionCount() == 0u)
+        return false;
+
+    this->publish(ConfigSnapshot::make(std::move(parser)));
+
+    return true;
+}
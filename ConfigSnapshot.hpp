@@ -0,0 +1,81 @@
+#ifndef _CONFIG_SNAPSHOT_HPP_
+#define _CONFIG_SNAPSHOT_HPP_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "CFGParser.hpp"
+
+
+/**
+    \brief Immutable loaded config, shared by any number of reader threads.
+    Parser is frozen and only its const interface is reachable, so readers need no locks:
+    lookups only read, typed conversion caches are written lock-free (see ValueSlot).
+    Snapshot lives as long as somebody holds it, values and handles stay valid till then.
+*/
+class ConfigSnapshot final
+{
+    std::unique_ptr<CFGParser> _parser;
+
+    explicit ConfigSnapshot(std::unique_ptr<CFGParser> parser) noexcept : _parser(std::move(parser)) {}
+
+public:
+    ConfigSnapshot(ConfigSnapshot const&) = delete;
+    ConfigSnapshot& operator=(ConfigSnapshot const&) = delete;
+
+    /**
+        \brief Takes loaded parser over and freezes it, parser must not be used by anybody else.
+        Config which cannot be frozen is still shared, lookups just go the usual way.
+    */
+    static std::shared_ptr<const ConfigSnapshot> make(std::unique_ptr<CFGParser> parser);
+
+    const CFGParser& config() const noexcept { return *_parser; }
+    const CFGParser* operator->() const noexcept { return _parser.get(); }
+};
+
+/**
+    \brief Current snapshot of a config which may be reloaded at runtime (read-copy-update).
+    Readers take the current snapshot and keep it as long as they need consistent values,
+    reload builds the new snapshot aside and swaps it in atomically. Old snapshot is released
+    by the last reader which still holds it, readers never wait for reload.
+*/
+class SharedConfig final
+{
+public:
+    /**
+        \brief Prepares every new parser before load: thread count, typed arrays, message functor...
+    */
+    using Setup = std::function<void(CFGParser&)>;
+
+private:
+    std::atomic<std::shared_ptr<const ConfigSnapshot>> _current;
+    Setup _setup;
+
+    // Reloads are built one at a time, readers never take it
+    std::mutex _reload_mutex;
+
+public:
+    SharedConfig() noexcept = default;
+    explicit SharedConfig(Setup setup) noexcept : _setup(std::move(setup)) {}
+
+    SharedConfig(SharedConfig const&) = delete;
+    SharedConfig& operator=(SharedConfig const&) = delete;
+
+    /**
+        \brief Snapshot readers work with, empty until the first publish.
+    */
+    std::shared_ptr<const ConfigSnapshot> current() const noexcept { return _current.load(std::memory_order_acquire); }
+
+    void publish(std::shared_ptr<const ConfigSnapshot> snapshot) noexcept { _current.store(std::move(snapshot), std::memory_order_release); }
+
+    /**
+        \brief Loads the file into a new parser and publishes it. Config without any section
+        (file cannot be opened, for example) is not published, current snapshot stays then.
+    */
+    const bool reload(const std::string& file_path);
+};
+
+#endif
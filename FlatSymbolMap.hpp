@@ -0,0 +1,164 @@
+#ifndef _FLAT_SYMBOL_MAP_HPP_
+#define _FLAT_SYMBOL_MAP_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include "SymbolTable.hpp"
+
+
+/**
+    \brief Symbol keyed hash map in one array (open addressing, linear probing).
+    Entries are never erased, so a lookup is a short scan of adjacent entries
+    and there is one allocation per map instead of one per entry.
+*/
+template<typename T>
+class FlatSymbolMap final
+{
+public:
+    using Symbol = SymbolTable::Symbol;
+
+    struct Entry final
+    {
+        Symbol key {SymbolTable::invalid_symbol};
+        T value {};
+    };
+
+    /**
+        \brief Walks filled entries, keys must not be changed through it.
+    */
+    template<typename E>
+    class BasicIterator final
+    {
+        E* _entry;
+        E* _end;
+
+    public:
+        BasicIterator(E* entry, E* end) noexcept : _entry(entry), _end(end) { this->skipEmpty(); }
+
+        E& operator*() const noexcept { return *_entry; }
+        E* operator->() const noexcept { return _entry; }
+
+        BasicIterator& operator++() noexcept
+        {
+            ++_entry;
+            this->skipEmpty();
+
+            return *this;
+        }
+
+        const bool operator==(const BasicIterator& other) const noexcept { return _entry == other._entry; }
+        const bool operator!=(const BasicIterator& other) const noexcept { return _entry != other._entry; }
+
+    private:
+        void skipEmpty() noexcept
+        {
+            while ((_entry != _end) && (_entry->key == SymbolTable::invalid_symbol))
+                ++_entry;
+        }
+    };
+
+    using Iterator = BasicIterator<Entry>;
+    using ConstIterator = BasicIterator<const Entry>;
+
+private:
+    std::vector<Entry> _entries;
+    size_t _size {0u};
+    uint32_t _shift {0u};
+
+public:
+    /**
+        \brief Makes room for count entries, so inserting them does not rehash.
+    */
+    void reserve(const size_t count)
+    {
+        // At most three quarters full
+        size_t capacity = 8u;
+        uint32_t shift = 61u;
+
+        while ((capacity * 3u) < (count * 4u))
+        {
+            capacity *= 2u;
+            --shift;
+        }
+
+        if (capacity <= _entries.size())
+            return;
+
+        std::vector<Entry> entries(capacity);
+        std::swap(entries, _entries);
+        _shift = shift;
+
+        for (auto& entry : entries)
+        {
+            if (entry.key != SymbolTable::invalid_symbol)
+                _entries[this->findIndex(entry.key)] = std::move(entry);
+        }
+    }
+
+    /**
+        \brief Inserts value unless key is already there, returns the stored value and whether it was inserted.
+    */
+    std::pair<T*, bool> try_emplace(const Symbol key, const T& value)
+    {
+        if (((_size + 1u) * 4u) > (_entries.size() * 3u))
+            this->reserve(_size + 1u);
+
+        Entry& entry = _entries[this->findIndex(key)];
+
+        if (entry.key == key)
+            return {&entry.value, false};
+
+        entry.key = key;
+        entry.value = value;
+        ++_size;
+
+        return {&entry.value, true};
+    }
+
+    const T* find(const Symbol key) const noexcept
+    {
+        // Invalid symbol is the empty entry marker
+        if (_entries.empty() || (key == SymbolTable::invalid_symbol))
+            return nullptr;
+
+        const Entry& entry = _entries[this->findIndex(key)];
+
+        return (entry.key == key) ? &entry.value : nullptr;
+    }
+
+    void clear() noexcept
+    {
+        _entries.clear();
+        _size = 0u;
+        _shift = 0u;
+    }
+
+    const size_t size() const noexcept { return _size; }
+    const bool empty() const noexcept { return _size == 0u; }
+
+    Iterator begin() noexcept { return {_entries.data(), _entries.data() + _entries.size()}; }
+    Iterator end() noexcept { return {_entries.data() + _entries.size(), _entries.data() + _entries.size()}; }
+
+    ConstIterator begin() const noexcept { return {_entries.data(), _entries.data() + _entries.size()}; }
+    ConstIterator end() const noexcept { return {_entries.data() + _entries.size(), _entries.data() + _entries.size()}; }
+
+private:
+    /**
+        \brief Entry which holds the key or empty entry where it should go.
+    */
+    size_t findIndex(const Symbol key) const noexcept
+    {
+        // Symbols are dense, Fibonacci hashing spreads neighbours over the table
+        const size_t mask = _entries.size() - 1u;
+        size_t index = static_cast<size_t>((static_cast<uint64_t>(key) * 11400714819323198485ull) >> _shift);
+
+        while ((_entries[index].key != key) && (_entries[index].key != SymbolTable::invalid_symbol))
+            index = (index + 1u) & mask;
+
+        return index;
+    }
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "FrozenIndex.hpp"
+#include <algorithm>
+#include <numeric>
+
+/**
+    \brief Buffers of placeHashes(), kept from one table to the next one.
+*/
+struct FrozenIndex::Placement final
+{
+    std::vector<uint64_t> sorted;
+    std::vector<uint32_t> bucket_begin;
+    std::vector<uint32_t> bucket_fill;
+    std::vector<uint32_t> bucket_hashes;
+    std::vector<uint32_t> order;
+    std::vector<bool> taken;
+    std::vector<uint32_t> bucket_slots;
+
+    // Slot of every hash, the result
+    std::vector<uint32_t> slots;
+};
+
+/**
+    \brief Hash and displace (CHD): hashes are put into buckets and buckets are placed biggest first,
+    each with the first displacement which moves all of its hashes to free slots.
+    Bucket of one hash just takes the next free slot, that is stored as negative displacement.
+*/
+const bool FrozenIndex::placeHashes(const std::vector<uint64_t>& hashes, int32_t* const displacements, Placement& placement)
+{
+    // Only a bad hash gives up after that many displacements, same hashes are caught before
+    static constexpr int32_t max_displacement {1 << 24};
+
+    const auto count = static_cast<uint32_t>(hashes.size());
+    const uint32_t bucket_count = bucketCount(count);
+
+    auto& [sorted, bucket_begin, bucket_fill, bucket_hashes, order, taken, bucket_slots, slots] = placement;
+
+    sorted.assign(hashes.cbegin(), hashes.cend());
+    std::sort(sorted.begin(), sorted.end());
+
+    if (std::adjacent_find(sorted.cbegin(), sorted.cend()) != sorted.cend())
+        return false;
+
+    // Hashes grouped by bucket
+    bucket_begin.assign(bucket_count + 1u, 0u);
+
+    for (const auto hash : hashes)
+        ++bucket_begin[bucketOf(hash, count) + 1u];
+
+    std::partial_sum(bucket_begin.cbegin(), bucket_begin.cend(), bucket_begin.begin());
+
+    bucket_hashes.resize(count);
+    bucket_fill.assign(bucket_begin.cbegin(), bucket_begin.cend() - 1);
+
+    for (uint32_t index = 0u; index < count; ++index)
+        bucket_hashes[bucket_fill[bucketOf(hashes[index], count)]++] = index;
+
+    order.resize(bucket_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&bucket_begin](const uint32_t left, const uint32_t right)
+    {
+        const uint32_t left_size = bucket_begin[left + 1u] - bucket_begin[left];
+        const uint32_t right_size = bucket_begin[right + 1u] - bucket_begin[right];
+
+        return (left_size != right_size) ? (left_size > right_size) : (left < right);
+    });
+
+    taken.assign(count, false);
+    slots.resize(count);
+
+    uint32_t next_free = 0u;
+
+    for (const auto bucket : order)
+    {
+        const uint32_t begin = bucket_begin[bucket];
+        const uint32_t size = bucket_begin[bucket + 1u] - begin;
+
+        displacements[bucket] = 0;
+
+        if (size == 0u)
+            continue;
+
+        if (size == 1u)
+        {
+            while (taken[next_free])
+                ++next_free;
+
+            taken[next_free] = true;
+            slots[bucket_hashes[begin]] = next_free;
+            displacements[bucket] = -static_cast<int32_t>(next_free) - 1;
+
+            continue;
+        }
+
+        for (int32_t displacement = 0;; ++displacement)
+        {
+            if (displacement == max_displacement)
+                return false;
+
+            bucket_slots.clear();
+
+            for (uint32_t index = begin; index < (begin + size); ++index)
+            {
+                const uint32_t slot = displace(hashes[bucket_hashes[index]], displacement, count);
+
+                if (taken[slot] || (std::find(bucket_slots.cbegin(), bucket_slots.cend(), slot) != bucket_slots.cend()))
+                    break;
+
+                bucket_slots.push_back(slot);
+            }
+
+            if (bucket_slots.size() != size)
+                continue;
+
+            for (uint32_t index = 0u; index < size; ++index)
+            {
+                taken[bucket_slots[index]] = true;
+                slots[bucket_hashes[begin + index]] = bucket_slots[index];
+            }
+
+            displacements[bucket] = displacement;
+
+            break;
+        }
+    }
+
+    return true;
+}
+
+const bool FrozenIndex::build(const SectionTable& sections, const SymbolTable& symbols)
+{
+    _sections.clear();
+    _section_displacements.clear();
+    _keys.clear();
+    _key_displacements.clear();
+
+    // Keys repeat across sections, so every name is hashed once
+    std::vector<uint64_t> name_hashes(symbols.size());
+    std::vector<const SectionTable::Section*> section_data;
+    std::vector<uint64_t> hashes;
+    Placement placement;
+    size_t key_total = 0u;
+
+    for (size_t symbol = 0u; symbol < name_hashes.size(); ++symbol)
+        name_hashes[symbol] = hashName(symbols.name(static_cast<SymbolTable::Symbol>(symbol)));
+
+    section_data.reserve(sections.size());
+    hashes.reserve(sections.size());
+
+    for (const auto& [symbol, section] : sections)
+    {
+        section_data.push_back(&section);
+        hashes.push_back(name_hashes[symbol]);
+        key_total += section.inheritances.empty() ? section.valueCount() : section.effective_values.size();
+    }
+
+    _sections.resize(section_data.size());
+    _section_displacements.resize(bucketCount(static_cast<uint32_t>(section_data.size())));
+    _keys.reserve(key_total);
+    _key_displacements.reserve(key_total / 4u + section_data.size());
+
+    if (!placeHashes(hashes, _section_displacements.data(), placement))
+    {
+        *this = FrozenIndex {};
+        return false;
+    }
+
+    // Keys of one section, slot order is found before they are stored
+    std::vector<Key> keys;
+    std::vector<uint64_t> key_hashes;
+    const std::vector<uint32_t> section_slots(std::move(placement.slots));
+    size_t index = 0u;
+
+    for (const auto& [symbol, section] : sections)
+    {
+        Section& frozen = _sections[section_slots[index]];
+        frozen.hash = hashes[index++];
+        frozen.name = symbols.name(symbol);
+
+        keys.clear();
+
+        // Linked sections have own and inherited keys together, own values win there already
+        if (section.inheritances.empty())
+        {
+            for (const auto& [key, value] : sections.values(section))
+                keys.push_back({name_hashes[key], symbols.name(key), &value, true});
+        }
+        else
+        {
+            for (const auto& [key, value] : section.effective_values)
+                keys.push_back({name_hashes[key], symbols.name(key), value, sections.findValue(section, key) == value});
+        }
+
+        key_hashes.resize(keys.size());
+
+        for (size_t key = 0u; key < keys.size(); ++key)
+            key_hashes[key] = keys[key].hash;
+
+        frozen.first_displacement = static_cast<uint32_t>(_key_displacements.size());
+        frozen.first_key = static_cast<uint32_t>(_keys.size());
+        frozen.key_count = static_cast<uint32_t>(keys.size());
+
+        _key_displacements.resize(_key_displacements.size() + bucketCount(frozen.key_count));
+        _keys.resize(_keys.size() + keys.size());
+
+        if (!placeHashes(key_hashes, _key_displacements.data() + frozen.first_displacement, placement))
+        {
+            *this = FrozenIndex {};
+            return false;
+        }
+
+        for (size_t key = 0u; key < keys.size(); ++key)
+            _keys[frozen.first_key + placement.slots[key]] = keys[key];
+    }
+
+    return true;
+}
@@ -0,0 +1,128 @@
+#ifndef _FROZEN_INDEX_HPP_
+#define _FROZEN_INDEX_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "SymbolTable.hpp"
+#include "SectionTable.hpp"
+#include "ValueSlot.hpp"
+
+
+/**
+    \brief Read-only index of a linked config, see CFGParser::freeze().
+    Section names and keys of every section (inherited ones included) get minimal perfect
+    hash functions, so a lookup is one hash of the name, one displacement and one compare
+    with the only slot the name can be in. Tables of all sections are packed into shared arrays.
+*/
+class FrozenIndex final
+{
+public:
+    struct Key final
+    {
+        uint64_t hash {0u};
+        std::string_view name;
+        const ValueSlot* value {nullptr};
+
+        // Key of the section itself, not one found through inheritance
+        bool own {false};
+    };
+
+    struct Section final
+    {
+        uint64_t hash {0u};
+        std::string_view name;
+
+        // Range of the section in shared displacement and key arrays
+        uint32_t first_displacement {0u};
+        uint32_t first_key {0u};
+        uint32_t key_count {0u};
+    };
+
+private:
+    struct Placement;
+
+    std::vector<Section> _sections;
+    std::vector<int32_t> _section_displacements;
+
+    std::vector<Key> _keys;
+    std::vector<int32_t> _key_displacements;
+
+public:
+    /**
+        \brief Builds the index over linked sections. Returns false if some names cannot be told apart
+        by their hashes, index is left empty then.
+    */
+    const bool build(const SectionTable& sections, const SymbolTable& symbols);
+
+    const Section* findSection(const std::string_view name) const noexcept
+    {
+        if (_sections.empty())
+            return nullptr;
+
+        const uint64_t hash = hashName(name);
+        const auto count = static_cast<uint32_t>(_sections.size());
+        const Section& section = _sections[slotOf(hash, _section_displacements.data(), count)];
+
+        return ((section.hash == hash) && (section.name == name)) ? &section : nullptr;
+    }
+
+    const Key* findKey(const Section& section, const std::string_view name) const noexcept
+    {
+        if (section.key_count == 0u)
+            return nullptr;
+
+        const uint64_t hash = hashName(name);
+        const Key& key = _keys[section.first_key + slotOf(hash, _key_displacements.data() + section.first_displacement, section.key_count)];
+
+        return ((key.hash == hash) && (key.name == name)) ? &key : nullptr;
+    }
+
+private:
+    static uint64_t hashName(const std::string_view name) noexcept
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>{}(name));
+    }
+
+    // Four names per bucket on average, bigger buckets make smaller tables but longer build
+    static uint32_t bucketCount(const uint32_t count) noexcept { return (count + 3u) / 4u; }
+
+    /**
+        \brief Maps 32-bit value to [0, range) without division.
+    */
+    static uint32_t reduce(const uint32_t value, const uint32_t range) noexcept
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(value) * range) >> 32u);
+    }
+
+    static uint32_t bucketOf(const uint64_t hash, const uint32_t count) noexcept
+    {
+        return reduce(static_cast<uint32_t>(hash >> 32u), bucketCount(count));
+    }
+
+    static uint32_t displace(const uint64_t hash, const int32_t displacement, const uint32_t count) noexcept
+    {
+        uint64_t mixed = hash ^ (static_cast<uint64_t>(displacement) * 0x9E3779B97F4A7C15ull);
+        mixed ^= mixed >> 31u;
+        mixed *= 0xBF58476D1CE4E5B9ull;
+        mixed ^= mixed >> 29u;
+
+        return reduce(static_cast<uint32_t>(mixed), count);
+    }
+
+    /**
+        \brief Slot of the hash in a table of count slots, negative displacement is the slot itself.
+    */
+    static uint32_t slotOf(const uint64_t hash, const int32_t* const displacements, const uint32_t count) noexcept
+    {
+        const int32_t displacement = displacements[bucketOf(hash, count)];
+
+        return (displacement < 0) ? static_cast<uint32_t>(-(displacement + 1)) : displace(hash, displacement, count);
+    }
+
+    static const bool placeHashes(const std::vector<uint64_t>& hashes, int32_t* const displacements, Placement& placement);
+};
+
+#endif
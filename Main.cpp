@@ -1,10 +1,467 @@
 #include "CFGParser.hpp"
+#include "ConfigSnapshot.hpp"
 #include <chrono>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <atomic>
+#include <thread>
+#include <new>
 
 
+// Heap allocations made by the program, see benchmarkLookup()
+static std::atomic<size_t> allocation_count {0u};
+
+void* operator new(std::size_t size)
+{
+	++allocation_count;
+
+	if (void* const pointer = std::malloc((size != 0u) ? size : 1u))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+
+/**
+	\brief Makes a big config out of test.cfg, every copy gets own section names.
+*/
+static std::string makeScaledConfig(const std::string& text, const size_t copies)
+{
+	std::string result;
+	result.reserve(text.size() * copies);
+
+	for (size_t copy = 0u; copy < copies; ++copy)
+	{
+		const std::string suffix = "_" + std::to_string(copy);
+
+		for (size_t line_begin = 0u; line_begin < text.size();)
+		{
+			size_t line_end = text.find('\n', line_begin);
+			line_end = (line_end == std::string::npos) ? text.size() : (line_end + 1u);
+
+			const std::string_view line(text.data() + line_begin, line_end - line_begin);
+			line_begin = line_end;
+
+			// Included files are not scaled
+			if (line.substr(0u, 1u) == "#")
+				continue;
+
+			const size_t name_end = line.find(']');
+
+			if ((line.substr(0u, 1u) != "[") || (name_end == std::string_view::npos))
+			{
+				result += line;
+				continue;
+			}
+
+			result += line.substr(0u, name_end);
+			result += suffix;
+			result += ']';
+
+			// Inherited names get the same suffix, attributes stay as is
+			std::string_view rest = line.substr(name_end + 1u);
+			const size_t inheritance_begin = rest.find(':');
+
+			if (inheritance_begin != std::string_view::npos)
+			{
+				const size_t inheritance_end = std::min(rest.find('='), rest.find_first_of("\r\n"));
+				std::string_view inheritances = rest.substr(inheritance_begin + 1u, inheritance_end - inheritance_begin - 1u);
+
+				result += " :";
+
+				for (size_t name_begin = 0u; name_begin <= inheritances.size();)
+				{
+					const size_t comma = std::min(inheritances.find(',', name_begin), inheritances.size());
+					std::string_view name = inheritances.substr(name_begin, comma - name_begin);
+
+					name.remove_prefix(std::min(name.find_first_not_of(' '), name.size()));
+					name = name.substr(0u, name.find(' '));
+
+					result += (name_begin == 0u) ? " " : ", ";
+					result += name;
+					result += suffix;
+
+					name_begin = comma + 1u;
+				}
+
+				result += (rest[inheritance_end] == '=') ? " " : "";
+				rest = rest.substr(inheritance_end);
+			}
+
+			result += rest;
+		}
+
+		result += '\n';
+	}
+
+	return result;
+}
+
+/**
+	\brief Best of several runs in milliseconds.
+*/
+template<typename F>
+static double measureBest(F&& function)
+{
+	double best_time = 0.0;
+
+	for (uint32_t run = 0u; run < 5u; ++run)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		function();
+		const auto end = std::chrono::steady_clock::now();
+
+		const double time = std::chrono::duration<double, std::milli>(end - begin).count();
+
+		if ((run == 0u) || (time < best_time))
+			best_time = time;
+	}
+
+	return best_time;
+}
+
+/**
+	\brief Parsing throughput on scaled test.cfg: tokenizer alone (streaming) and full load.
+*/
+static void benchmarkParser(const size_t copies)
+{
+	std::ifstream file("test.cfg", std::ios::binary);
+	std::stringstream stream;
+	stream << file.rdbuf();
+
+	const std::string config = makeScaledConfig(stream.str(), copies);
+	const double megabytes = static_cast<double>(config.size()) / (1024.0 * 1024.0);
+
+	const double stream_time = measureBest([&config]()
+	{
+		CFGParser cfg;
+		CFGParser::Visitor visitor;
+		cfg.streamFromMemory(config, visitor);
+	});
+
+	const double load_time = measureBest([&config]()
+	{
+		CFGParser cfg;
+		cfg.setMessageFunctor([](const std::string&) {});
+		cfg.loadFromMemory(config);
+	});
+
+	std::cout << "Config: " << megabytes << " MB" << std::endl;
+	std::cout << "Tokenizer: " << stream_time << " ms, " << (megabytes * 1000.0 / stream_time) << " MB/s" << std::endl;
+	std::cout << "Load: " << load_time << " ms, " << (megabytes * 1000.0 / load_time) << " MB/s" << std::endl;
+}
+
+/**
+	\brief Conversion of a long numeric array value (lookup tables, curves).
+*/
+static void benchmarkArray(const size_t elements)
+{
+	std::string config = "[table]\nvalues = ";
+
+	for (size_t element = 0u; element < elements; ++element)
+	{
+		const int64_t value = static_cast<int64_t>((element * 7919u) % 2000000u) - 1000000;
+
+		config += (element != 0u) ? "," : "";
+		config += std::to_string(value / 1000) + "." + std::to_string(1000 + std::abs(value % 1000)).substr(1u);
+	}
+
+	config += "\n";
+
+	CFGParser cfg;
+	cfg.loadFromMemory(config);
+
+	std::vector<float> values(elements);
+
+	const double array_time = measureBest([&cfg, &values]()
+	{
+		cfg.getArray<float>("table", "values", std::span<float>(values));
+	});
+
+	std::cout << "getArray<float> of " << elements << " elements: " << array_time << " ms" << std::endl;
+
+	const double load_time = measureBest([&config]()
+	{
+		CFGParser typed_cfg;
+		typed_cfg.setTypedArrays<float>();
+		typed_cfg.loadFromMemory(config);
+	});
+
+	const double text_load_time = measureBest([&config]()
+	{
+		CFGParser text_cfg;
+		text_cfg.loadFromMemory(config);
+	});
+
+	CFGParser typed_cfg;
+	typed_cfg.setTypedArrays<float>();
+	typed_cfg.loadFromMemory(config);
+
+	volatile float sink = 0.0f;
+
+	const double view_time = measureBest([&typed_cfg, &sink]()
+	{
+		sink = sink + typed_cfg.getArrayView<float>("table", "values")[0];
+	});
+
+	std::cout << "Load of " << elements << " elements: " << text_load_time << " ms, typed: " << load_time << " ms, getArrayView<float>: " << view_time << " ms" << std::endl;
+}
+
+/**
+	\brief Lookup cost on test.cfg, string literals must not cost any allocation.
+*/
+static void benchmarkLookup()
+{
+	CFGParser cfg;
+	cfg.setMessageFunctor([](const std::string&) {});
+	cfg.load("test.cfg");
+
+	constexpr size_t lookups {1000000u};
+	volatile int sink = 0;
+
+	const auto Lookups = [&cfg, &sink]()
+	{
+		for (size_t lookup = 0u; lookup < lookups; ++lookup)
+			sink = sink + cfg.get<int>("test", "val");
+	};
+
+	const size_t allocations_before = allocation_count;
+	Lookups();
+	const size_t allocations = allocation_count - allocations_before;
+
+	const double lookup_time = measureBest(Lookups);
+
+	std::cout << "get<int>: " << (lookup_time * 1000000.0 / lookups) << " ns, "
+		<< (static_cast<double>(allocations) / lookups) << " allocations per call" << std::endl;
+
+	const auto handle = cfg.resolve("test", "val");
+
+	const double handle_time = measureBest([&cfg, &sink, &handle]()
+	{
+		for (size_t lookup = 0u; lookup < lookups; ++lookup)
+			sink = sink + cfg.get<int>(handle);
+	});
+
+	std::cout << "get<int> by handle: " << (handle_time * 1000000.0 / lookups) << " ns" << std::endl;
+
+	const auto ArrayLookups = [&cfg, &sink]()
+	{
+		std::array<int, 3> values {};
+
+		for (size_t lookup = 0u; lookup < lookups; ++lookup)
+		{
+			cfg.getArray("test", "array", values);
+			sink = sink + values[2];
+		}
+	};
+
+	const size_t array_allocations_before = allocation_count;
+	ArrayLookups();
+	const size_t array_allocations = allocation_count - array_allocations_before;
+
+	const double array_time = measureBest(ArrayLookups);
+
+	std::cout << "getArray<int, 3>: " << (array_time * 1000000.0 / lookups) << " ns, "
+		<< (static_cast<double>(array_allocations) / lookups) << " allocations per call" << std::endl;
+}
+
+/**
+	\brief Reads and writes per second of reader and writer threads on one config in concurrent mode.
+	Every thread picks sections of scaled test.cfg at random, so they meet only by chance.
+*/
+static void benchmarkContention(const uint32_t readers, const uint32_t writers)
+{
+	constexpr size_t copies {10000u};
+
+	std::ifstream file("test.cfg", std::ios::binary);
+	std::stringstream stream;
+	stream << file.rdbuf();
+
+	CFGParser cfg;
+	cfg.setMessageFunctor([](const std::string&) {});
+	cfg.setConcurrent(true);
+	cfg.loadFromMemory(makeScaledConfig(stream.str(), copies));
+
+	std::vector<std::string> sections(copies);
+
+	for (size_t copy = 0u; copy < copies; ++copy)
+		sections[copy] = "test_" + std::to_string(copy);
+
+	std::atomic<bool> stop {false};
+	std::atomic<size_t> reads {0u};
+	std::atomic<size_t> writes {0u};
+	std::vector<std::thread> threads;
+
+	const auto Worker = [&cfg, &sections, &stop](const uint32_t seed, const bool writer, std::atomic<size_t>& total)
+	{
+		uint32_t state = (seed * 2654435761u) + 1u;
+		size_t count = 0u;
+		volatile int sink = 0;
+
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			state = (state * 1664525u) + 1013904223u;
+			const std::string& section = sections[(state >> 8u) % sections.size()];
+
+			if (writer)
+				cfg.set(section, "val", static_cast<int>(count));
+			else
+				sink = sink + cfg.get<int>(section, "val");
+
+			++count;
+		}
+
+		total += count;
+	};
+
+	for (uint32_t reader = 0u; reader < readers; ++reader)
+		threads.emplace_back(Worker, reader, false, std::ref(reads));
+
+	for (uint32_t writer = 0u; writer < writers; ++writer)
+		threads.emplace_back(Worker, readers + writer, true, std::ref(writes));
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+	stop = true;
+
+	for (auto& thread : threads)
+		thread.join();
+
+	std::cout << readers << " readers, " << writers << " writers: "
+		<< (static_cast<double>(reads) / 1000000.0) << " M reads/s, "
+		<< (static_cast<double>(writes) / 1000000.0) << " M writes/s" << std::endl;
+}
+
+/**
+	\brief Readers of SharedConfig while another thread keeps reloading it.
+	Two versions of scaled test.cfg are reloaded in turn. Every reader checks that the snapshot
+	it holds gives the same version before and after its reads, whatever reload does meanwhile.
+*/
+static void benchmarkSnapshot(const uint32_t readers)
+{
+	constexpr size_t copies {1000u};
+
+	std::ifstream file("test.cfg", std::ios::binary);
+	std::stringstream stream;
+	stream << file.rdbuf();
+
+	const std::string config = makeScaledConfig(stream.str(), copies);
+	std::array<std::string, 2u> paths;
+
+	for (size_t version = 0u; version < paths.size(); ++version)
+	{
+		paths[version] = (std::filesystem::temp_directory_path() / ("cfg_snapshot" + std::to_string(version) + ".cfg")).string();
+
+		std::ofstream output(paths[version], std::ios::binary);
+		output << config << "[snapshot]\nversion = " << version << "\n";
+	}
+
+	std::vector<std::string> sections(copies);
+
+	for (size_t copy = 0u; copy < copies; ++copy)
+		sections[copy] = "test_" + std::to_string(copy);
+
+	SharedConfig shared([](CFGParser& cfg) { cfg.setMessageFunctor([](const std::string&) {}); });
+	shared.reload(paths[0]);
+
+	// Held for the whole run, reloads must not touch it
+	const auto first = shared.current();
+
+	std::atomic<bool> stop {false};
+	std::atomic<size_t> reads {0u};
+	std::atomic<size_t> swaps_seen {0u};
+	std::atomic<size_t> inconsistent {0u};
+	std::vector<std::thread> threads;
+
+	for (uint32_t reader = 0u; reader < readers; ++reader)
+	{
+		threads.emplace_back([&shared, &sections, &stop, &reads, &swaps_seen, &inconsistent, reader]()
+		{
+			uint32_t state = (reader * 2654435761u) + 1u;
+			size_t count = 0u;
+			size_t swaps = 0u;
+			int last_version = -1;
+			volatile int sink = 0;
+
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				const auto snapshot = shared.current();
+				const int version = snapshot->config().get<int>("snapshot", "version", -1);
+
+				for (uint32_t lookup = 0u; lookup < 16u; ++lookup)
+				{
+					state = (state * 1664525u) + 1013904223u;
+					sink = sink + snapshot->config().get<int>(sections[(state >> 8u) % sections.size()], "val");
+				}
+
+				if (snapshot->config().get<int>("snapshot", "version", -1) != version)
+					++inconsistent;
+
+				swaps += ((last_version != -1) && (version != last_version)) ? 1u : 0u;
+				last_version = version;
+				count += 18u;
+			}
+
+			reads += count;
+			swaps_seen += swaps;
+		});
+	}
+
+	size_t reloads = 0u;
+	const auto reload_begin = std::chrono::steady_clock::now();
+
+	while ((std::chrono::steady_clock::now() - reload_begin) < std::chrono::seconds(1))
+	{
+		if (shared.reload(paths[(reloads + 1u) % paths.size()]))
+			++reloads;
+	}
+
+	stop = true;
+
+	for (auto& thread : threads)
+		thread.join();
+
+	for (const auto& path : paths)
+		std::filesystem::remove(path);
+
+	std::cout << readers << " readers: " << (static_cast<double>(reads) / 1000000.0) << " M reads/s, "
+		<< reloads << " reloads, " << swaps_seen << " swaps seen, " << inconsistent << " inconsistent snapshots, "
+		<< "first snapshot version " << first->config().get<int>("snapshot", "version", -1) << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
+	if ((argc > 1) && (std::strcmp(argv[1], "bench") == 0))
+	{
+		benchmarkParser((argc > 2) ? std::stoul(argv[2]) : 100000u);
+		benchmarkLookup();
+		benchmarkArray(100000u);
+		return 0;
+	}
+
+	if ((argc > 1) && (std::strcmp(argv[1], "contention") == 0))
+	{
+		const auto readers = static_cast<uint32_t>((argc > 2) ? std::stoul(argv[2]) : 8u);
+		const auto writers = static_cast<uint32_t>((argc > 3) ? std::stoul(argv[3]) : 2u);
+
+		// Readers alone first, then the same readers with writers
+		benchmarkContention(readers, 0u);
+		benchmarkContention(readers, writers);
+		return 0;
+	}
+
+	if ((argc > 1) && (std::strcmp(argv[1], "snapshot") == 0))
+	{
+		benchmarkSnapshot(static_cast<uint32_t>((argc > 2) ? std::stoul(argv[2]) : 8u));
+		return 0;
+	}
+
 	const auto iter_begin = std::chrono::steady_clock::now();
 	CFGParser cfg("test.cfg");
 	const auto iter_end = std::chrono::steady_clock::now();
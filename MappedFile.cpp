@@ -0,0 +1,228 @@
+#include "MappedFile.hpp"
+#include <utility>
+#include <algorithm>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <fstream>
+    #include <iterator>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->close();
+
+        _buffer = std::move(other._buffer);
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0u);
+        _mapped = std::exchange(other._mapped, false);
+        _open = std::exchange(other._open, false);
+    }
+
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& file_path)
+{
+    this->close();
+
+    const HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size {};
+
+    if ((GetFileType(file) == FILE_TYPE_DISK) && GetFileSizeEx(file, &file_size))
+    {
+        if (file_size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            _open = true;
+            return true;
+        }
+
+        if (const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            mapping != nullptr)
+        {
+            // The view keeps the mapping object alive by itself
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+            CloseHandle(mapping);
+
+            if (view != nullptr)
+            {
+                CloseHandle(file);
+
+                _data = static_cast<const char*>(view);
+                _size = static_cast<size_t>(file_size.QuadPart);
+                _mapped = true;
+                _open = true;
+
+                return true;
+            }
+        }
+    }
+
+    CloseHandle(file);
+
+    std::ifstream stream(file_path, std::ios::binary);
+
+    if (!stream.good())
+        return false;
+
+    _buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    _data = _buffer.data();
+    _size = _buffer.size();
+    _open = true;
+
+    return true;
+}
+
+void MappedFile::release(const char* const position) noexcept
+{
+    // Unmodified file pages are trimmed by the system on its own
+    (void)position;
+}
+
+void MappedFile::close() noexcept
+{
+    if (_mapped)
+        UnmapViewOfFile(_data);
+
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+    _data = nullptr;
+    _size = 0u;
+    _mapped = false;
+    _open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& file_path)
+{
+    this->close();
+
+    const int descriptor = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (descriptor < 0)
+        return false;
+
+    struct stat file_stat {};
+
+    if ((fstat(descriptor, &file_stat) == 0) && S_ISREG(file_stat.st_mode))
+    {
+        if (file_stat.st_size == 0)
+        {
+            ::close(descriptor);
+            _open = true;
+            return true;
+        }
+
+        const size_t file_size = static_cast<size_t>(file_stat.st_size);
+
+        if (void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            view != MAP_FAILED)
+        {
+            // We read the whole thing front to back exactly once
+            madvise(view, file_size, MADV_SEQUENTIAL);
+
+            ::close(descriptor);
+
+            _data = static_cast<const char*>(view);
+            _size = file_size;
+            _mapped = true;
+            _open = true;
+
+            return true;
+        }
+    }
+
+    // Pipes, sockets, procfs and friends: plain read() into a growing buffer
+    constexpr size_t read_block {64u * 1024u};
+    size_t used = 0u;
+
+    for (;;)
+    {
+        if (_buffer.size() - used < read_block)
+            _buffer.resize(used + read_block);
+
+        const ssize_t read_size = ::read(descriptor, _buffer.data() + used, _buffer.size() - used);
+
+        if (read_size > 0)
+        {
+            used += static_cast<size_t>(read_size);
+        }
+        else if (read_size == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            ::close(descriptor);
+            _buffer.clear();
+            return false;
+        }
+    }
+
+    ::close(descriptor);
+
+    _buffer.resize(used);
+    _data = _buffer.data();
+    _size = _buffer.size();
+    _open = true;
+
+    return true;
+}
+
+void MappedFile::release(const char* const position) noexcept
+{
+    if (!_mapped || (position <= _data))
+        return;
+
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t size = std::min(static_cast<size_t>(position - _data), _size) & ~(page_size - 1u);
+
+    // Mapping is read-only, so nothing gets lost
+    if (size != 0u)
+        madvise(const_cast<char*>(_data), size, MADV_DONTNEED);
+}
+
+void MappedFile::close() noexcept
+{
+    if (_mapped)
+        munmap(const_cast<char*>(_data), _size);
+
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+    _data = nullptr;
+    _size = 0u;
+    _mapped = false;
+    _open = false;
+}
+
+#endif
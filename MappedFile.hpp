@@ -0,0 +1,58 @@
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+/**
+    \brief Read-only view of a whole file.
+    Regular files are memory-mapped, anything that cannot be mapped
+    (pipes, character devices) is read into an owned buffer instead.
+*/
+class MappedFile final
+{
+    const char* _data {nullptr};
+    size_t _size {0u};
+
+    // Fallback storage for unmappable files
+    std::vector<char> _buffer;
+
+    bool _mapped {false};
+    bool _open {false};
+
+public:
+    MappedFile() noexcept = default;
+    MappedFile(const std::string& file_path) { this->open(file_path); }
+    ~MappedFile() noexcept { this->close(); }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+        \brief Maps file into memory. Returns false if file cannot be opened.
+    */
+    bool open(const std::string& file_path);
+    void close() noexcept;
+
+    /**
+        \brief Hint that data before position is not needed anymore, its pages may be dropped.
+        Memory stays readable, dropped pages are read from file again when touched.
+    */
+    void release(const char* const position) noexcept;
+
+    const bool isOpen() const noexcept { return _open; }
+    const bool isMapped() const noexcept { return _mapped; }
+
+    const char* data() const noexcept { return _data; }
+    const size_t size() const noexcept { return _size; }
+
+    const char* begin() const noexcept { return _data; }
+    const char* end() const noexcept { return _data + _size; }
+};
+
+#endif
@@ -0,0 +1,428 @@
+#ifndef _NUMBER_PARSER_HPP_
+#define _NUMBER_PARSER_HPP_
+
+#include <array>
+#include <bit>
+#include <cfloat>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CFG_NUMBERS_SSE2
+#endif
+
+
+/**
+    \brief Fast path for plain decimal numbers, as found in long numeric arrays.
+    Short numbers are checked and combined in one 64-bit word, longer ones are classified
+    16 bytes at a time, and floats are built with a single exactly rounded division
+    (Clinger's fast path), so every result is bit for bit what std::from_chars gives.
+    Anything else (exponents, long mantissas, inf, nan, out of range) is left to std::from_chars.
+*/
+class NumberParser final
+{
+    static constexpr std::array<uint64_t, 20u> integer_powers
+    {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull
+    };
+
+    // Powers of ten which are exact in the type
+    static constexpr std::array<float, 11u> float_powers
+    {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+
+    static constexpr std::array<double, 23u> double_powers
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Longest mantissa which is combined in one 64-bit integer
+    static constexpr uint32_t max_mantissa_digits {19u};
+
+    static constexpr size_t block_size {64u};
+
+public:
+    template<typename T>
+    static constexpr bool isSupported() noexcept
+    {
+        // Single rounding of float arithmetic is needed for exact results
+        constexpr bool exact_floats = (FLT_EVAL_METHOD == 0);
+
+        return (std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+            (exact_floats && (std::is_same<T, float>::value || std::is_same<T, double>::value));
+    }
+
+    /**
+        \brief Parses number at the beginning of text, as std::from_chars would (leading '+' is taken too).
+        Returns end of the number, or nullptr if it has to be converted by std::from_chars,
+        value is written only on success.
+        Characters up to limit may be read (but are never parsed), so elements of an array
+        are parsed in whole blocks and their length does not cost a branch per digit.
+    */
+    template<typename T>
+    static inline const char* parse(const char* position, const char* const end, const char* const limit, T& value) noexcept
+    {
+        static_assert(isSupported<T>(), "Number type has no fast path");
+
+        if (position == end)
+            return nullptr;
+
+        // Sign of numbers in an array is random, so no branch on it
+        const bool negative = (*position == '-');
+        position += static_cast<ptrdiff_t>(negative || (*position == '+'));
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            if (((limit - position) >= 8) && ((end - position) <= 8) && parseWord(position, end, negative, value))
+                return end;
+        }
+
+#if defined(CFG_NUMBERS_SSE2)
+        if (((limit - position) >= 16) && ((end - position) <= 16) && parseBlock(position, end, negative, value))
+            return end;
+#endif
+
+        const uint32_t integer_digits = countDigits(position, end, limit);
+
+        if constexpr (std::is_integral<T>::value)
+        {
+            if ((integer_digits == 0u) || !makeValue(negative, readDigits(position, integer_digits, limit), integer_digits, 0u, value))
+                return nullptr;
+
+            return position + integer_digits;
+        }
+        else
+        {
+            if (integer_digits == 0u)
+                return nullptr;
+
+            const char* number_end = position + integer_digits;
+            uint32_t fraction_digits = 0u;
+
+            if ((number_end != end) && (*number_end == '.'))
+            {
+                fraction_digits = countDigits(number_end + 1, end, limit);
+
+                if (fraction_digits == 0u)
+                    return nullptr;
+
+                number_end += fraction_digits + 1u;
+            }
+
+            if (((number_end != end) && ((*number_end == 'e') || (*number_end == 'E'))) ||
+                ((integer_digits + fraction_digits) > max_mantissa_digits))
+                return nullptr;
+
+            uint64_t mantissa = readDigits(position, integer_digits, limit);
+
+            if (fraction_digits != 0u)
+                mantissa = (mantissa * integer_powers[fraction_digits]) + readDigits(position + integer_digits + 1u, fraction_digits, limit);
+
+            if (!makeValue(negative, mantissa, integer_digits + fraction_digits, fraction_digits, value))
+                return nullptr;
+
+            return number_end;
+        }
+    }
+
+    template<typename T>
+    static inline const char* parse(const char* const position, const char* const end, T& value) noexcept
+    {
+        return parse(position, end, end, value);
+    }
+
+    /**
+        \brief Calls element(begin, end) for every comma separated element of the text, in order,
+        until it returns false. Commas are found a block at a time, so elements are parsed
+        with known bounds and do not wait for each other.
+    */
+    template<typename F>
+    static inline void split(const char* const begin, const char* const end, F&& element)
+    {
+        const char* element_begin = begin;
+
+        for (const char* block = begin; block < end; block += block_size)
+        {
+            uint64_t commas = 0u;
+
+            if (static_cast<size_t>(end - block) >= block_size)
+            {
+                commas = findCommas(block);
+            }
+            else
+            {
+                // Tail block: never read past the input
+                std::array<char, block_size> padded {};
+                std::memcpy(padded.data(), block, static_cast<size_t>(end - block));
+
+                commas = findCommas(padded.data());
+            }
+
+            for (; commas != 0u; commas &= commas - 1u)
+            {
+                const char* const comma = block + std::countr_zero(commas);
+
+                if (!element(element_begin, comma))
+                    return;
+
+                element_begin = comma + 1;
+            }
+        }
+
+        element(element_begin, end);
+    }
+
+private:
+    /**
+        \brief Value of mantissa / 10^fraction_digits, false if it does not take the fast path.
+    */
+    template<typename T>
+    static inline bool makeValue(const bool negative, const uint64_t mantissa, const uint32_t digits, const uint32_t fraction_digits, T& value) noexcept
+    {
+        if constexpr (std::is_integral<T>::value)
+        {
+            // Any number of digits10 digits fits the type
+            if ((digits > static_cast<uint32_t>(std::numeric_limits<T>::digits10)) || (negative && std::is_unsigned<T>::value))
+                return false;
+
+            // Sign of numbers in an array is random, so it is applied without a branch
+            if constexpr (std::is_signed<T>::value)
+                value = static_cast<T>((mantissa ^ (0ull - negative)) + negative);
+            else
+                value = static_cast<T>(mantissa);
+        }
+        else
+        {
+            // Both operands are exact, so the quotient is rounded once
+            T result;
+
+            if constexpr (std::is_same<T, float>::value)
+            {
+                if ((mantissa > (1ull << 24u)) || (fraction_digits >= float_powers.size()))
+                    return false;
+
+                result = static_cast<float>(mantissa) / float_powers[fraction_digits];
+            }
+            else
+            {
+                if ((mantissa > (1ull << 53u)) || (fraction_digits >= double_powers.size()))
+                    return false;
+
+                result = static_cast<double>(mantissa) / double_powers[fraction_digits];
+            }
+
+            using Bits = std::conditional_t<std::is_same<T, float>::value, uint32_t, uint64_t>;
+            value = std::bit_cast<T>(std::bit_cast<Bits>(result) ^ (static_cast<Bits>(negative) << ((sizeof(Bits) * 8u) - 1u)));
+        }
+
+        return true;
+    }
+
+    /**
+        \brief Number which fills the whole range (at most 8 characters, 8 readable) in one 64-bit word:
+        dot is found and dropped, digits are checked and combined all at once. Little endian only.
+    */
+    template<typename T>
+    static inline bool parseWord(const char* const position, const char* const end, const bool negative, T& value) noexcept
+    {
+        uint32_t length = static_cast<uint32_t>(end - position);
+
+        if (length == 0u)
+            return false;
+
+        uint64_t word = 0u;
+        std::memcpy(&word, position, sizeof(word));
+
+        uint32_t fraction_digits = 0u;
+
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            // Zero byte test: lowest marked byte is the first dot, more marks mean more dots (or a false mark above it)
+            const uint64_t dot_bytes = word ^ 0x2E2E2E2E2E2E2E2Eull;
+            const uint64_t dots = (dot_bytes - 0x0101010101010101ull) & ~dot_bytes & 0x8080808080808080ull &
+                (~0ull >> ((8u - length) * 8u));
+
+            if (dots != 0u)
+            {
+                const uint32_t dot = static_cast<uint32_t>(std::countr_zero(dots)) / 8u;
+
+                // Numbers like "1." or ".5" take the long way
+                if (((dots & (dots - 1u)) != 0u) || (dot == 0u) || (dot == (length - 1u)))
+                    return false;
+
+                // Dot is dropped before '0' is taken, it would borrow from the next digit
+                const uint64_t below_dot = (1ull << (dot * 8u)) - 1u;
+                word = (word & below_dot) | ((word >> 8u) & ~below_dot);
+
+                --length;
+                fraction_digits = length - dot;
+            }
+        }
+
+        // Digits go to the top, missing ones come in as leading zeros
+        const uint32_t missing = (8u - length) * 8u;
+
+        if (missing != 0u)
+            word = (word << missing) | (0x3030303030303030ull >> (64u - missing));
+
+        // Every byte is 0x30..0x39
+        if (((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4u)) != 0x3333333333333333ull)
+            return false;
+
+        return makeValue(negative, combineEightDigits(word - 0x3030303030303030ull), length, fraction_digits, value);
+    }
+
+#if defined(CFG_NUMBERS_SSE2)
+    /**
+        \brief Number which fills the whole range (at most 16 characters, 16 readable),
+        classified at once: digits with at most one dot between them. Anything else is left to the caller.
+    */
+    template<typename T>
+    static inline bool parseBlock(const char* const position, const char* const end, const bool negative, T& value) noexcept
+    {
+        const uint32_t length = static_cast<uint32_t>(end - position);
+        const uint32_t in_number = (1u << length) - 1u;
+
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+        const __m128i nine = _mm_set1_epi8(9);
+
+        const uint32_t digits = in_number & static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_max_epu8(_mm_sub_epi8(bytes, _mm_set1_epi8('0')), nine), nine)));
+        const uint32_t dots = in_number & static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'))));
+
+        if ((digits == 0u) || ((digits | dots) != in_number) || ((dots & (dots - 1u)) != 0u))
+            return false;
+
+        if (dots == 0u)
+            return makeValue(negative, readDigits(position, length, position + 16), length, 0u, value);
+
+        // Integer types and numbers like "1." or ".5" take the long way
+        if (std::is_integral<T>::value || ((dots & (1u | (1u << (length - 1u)))) != 0u))
+            return false;
+
+        const uint32_t dot = static_cast<uint32_t>(std::countr_zero(dots));
+        const uint32_t fraction_digits = length - dot - 1u;
+        const uint64_t mantissa = (readDigits(position, dot, position + 16) * integer_powers[fraction_digits]) +
+            readDigits(position + dot + 1u, fraction_digits, position + 16);
+
+        return makeValue(negative, mantissa, length - 1u, fraction_digits, value);
+    }
+#endif
+
+    /**
+        \brief One bit per comma of a full block.
+    */
+    static inline uint64_t findCommas(const char* const block) noexcept
+    {
+        uint64_t mask = 0u;
+
+#if defined(CFG_NUMBERS_SSE2)
+        const __m128i comma = _mm_set1_epi8(',');
+
+        for (uint32_t offset = 0u; offset < block_size; offset += 16u)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset));
+            mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)))) << offset;
+        }
+#else
+        for (uint32_t offset = 0u; offset < block_size; ++offset)
+            mask |= static_cast<uint64_t>(block[offset] == ',') << offset;
+#endif
+
+        return mask;
+    }
+
+    /**
+        \brief Number of decimal digits from position up to end, counted up to max_mantissa_digits + 1.
+    */
+    static inline uint32_t countDigits(const char* const position, const char* const end, const char* const limit) noexcept
+    {
+        uint32_t count = 0u;
+
+#if defined(CFG_NUMBERS_SSE2)
+        if ((limit - position) >= 16)
+        {
+            const __m128i bytes = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position)), _mm_set1_epi8('0'));
+
+            // Digit is 0..9 after subtraction, anything else is above as unsigned
+            const __m128i nine = _mm_set1_epi8(9);
+            uint32_t digits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, nine), nine)));
+
+            // Bytes past end are read, but never counted
+            if ((end - position) < 16)
+                digits &= (1u << static_cast<uint32_t>(end - position)) - 1u;
+
+            if (digits != 0xFFFFu)
+                return static_cast<uint32_t>(std::countr_zero(~digits));
+
+            count = 16u;
+        }
+#endif
+
+        while ((count <= max_mantissa_digits) && ((position + count) != end) &&
+            (static_cast<uint8_t>(position[count] - '0') <= 9u))
+            ++count;
+
+        return count;
+    }
+
+    /**
+        \brief Value of count digits (at most max_mantissa_digits), characters up to limit may be read.
+    */
+    static inline uint64_t readDigits(const char* position, uint32_t count, const char* const limit) noexcept
+    {
+        uint64_t result = 0u;
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            for (; count >= 8u; count -= 8u, position += 8)
+                result = (result * 100000000u) + combineEightDigits(loadDigits(position));
+
+            if ((count != 0u) && ((limit - position) >= 8))
+            {
+                // Bytes past the digits are shifted out, missing digits come in as leading zeros
+                const uint64_t digits = loadDigits(position) << ((8u - count) * 8u);
+
+                return (result * integer_powers[count]) + combineEightDigits(digits);
+            }
+        }
+
+        for (; count != 0u; --count, ++position)
+            result = (result * 10u) + static_cast<uint64_t>(*position - '0');
+
+        return result;
+    }
+
+    /**
+        \brief Eight characters with '0' taken from every byte, first one in the lowest byte.
+    */
+    static inline uint64_t loadDigits(const char* const position) noexcept
+    {
+        uint64_t digits = 0u;
+        std::memcpy(&digits, position, sizeof(digits));
+
+        // Digits never borrow, anything borrowing after them is shifted out or ignored
+        return digits - 0x3030303030303030ull;
+    }
+
+    static inline uint64_t combineEightDigits(uint64_t digits) noexcept
+    {
+        // Pairs, then quads, then all eight
+        digits = (digits * 10u) + (digits >> 8u);
+        digits = (((digits & 0x000000FF000000FFull) * (100u + (1000000ull << 32u))) +
+            (((digits >> 16u) & 0x000000FF000000FFull) * (1u + (10000ull << 32u)))) >> 32u;
+
+        return static_cast<uint32_t>(digits);
+    }
+};
+
+#endif
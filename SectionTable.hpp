@@ -0,0 +1,479 @@
+#ifndef _SECTION_TABLE_HPP_
+#define _SECTION_TABLE_HPP_
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CFG_SECTION_TABLE_SSE2
+#endif
+
+#include "SymbolTable.hpp"
+#include "FlatSymbolMap.hpp"
+#include "AttributeSet.hpp"
+#include "ValueSlot.hpp"
+
+
+/**
+    \brief Array which grows by blocks of doubling size.
+    Elements never move once added and there are only a few dozen allocations
+    however many elements there are.
+*/
+template<typename T>
+class BlockArray final
+{
+    // First block holds 2^first_block_bits elements
+    static constexpr uint32_t first_block_bits {6u};
+
+    std::vector<T*> _blocks;
+    size_t _size {0u};
+
+public:
+    BlockArray() noexcept = default;
+    ~BlockArray() noexcept { this->clear(); }
+
+    BlockArray(BlockArray&& other) noexcept : _blocks(std::move(other._blocks)), _size(other._size) { other._size = 0u; }
+
+    BlockArray& operator=(BlockArray&& other) noexcept
+    {
+        this->clear();
+        std::swap(_blocks, other._blocks);
+        std::swap(_size, other._size);
+
+        return *this;
+    }
+
+    BlockArray(BlockArray const&) = delete;
+    BlockArray& operator=(BlockArray const&) = delete;
+
+    T& operator[](const size_t index) noexcept
+    {
+        const size_t biased = index + (size_t(1u) << first_block_bits);
+        const uint32_t block = static_cast<uint32_t>(std::bit_width(biased)) - 1u - first_block_bits;
+
+        return _blocks[block][biased - (size_t(1u) << (block + first_block_bits))];
+    }
+
+    const T& operator[](const size_t index) const noexcept
+    {
+        return const_cast<BlockArray&>(*this)[index];
+    }
+
+    template<typename... A>
+    T& emplace_back(A&&... arguments)
+    {
+        // Block k starts at element 2^first_block_bits * (2^k - 1)
+        if (_size == (((size_t(1u) << _blocks.size()) - 1u) << first_block_bits))
+            _blocks.push_back(std::allocator<T>().allocate(size_t(1u) << (_blocks.size() + first_block_bits)));
+
+        T* const element = new (&(*this)[_size]) T(std::forward<A>(arguments)...);
+        ++_size;
+
+        return *element;
+    }
+
+    const size_t size() const noexcept { return _size; }
+
+    void clear() noexcept
+    {
+        for (size_t index = 0u; index < _size; ++index)
+            (*this)[index].~T();
+
+        for (size_t block = 0u; block < _blocks.size(); ++block)
+            std::allocator<T>().deallocate(_blocks[block], size_t(1u) << (block + first_block_bits));
+
+        _blocks.clear();
+        _size = 0u;
+    }
+};
+
+/**
+    \brief Sections with their values, stored flat instead of a hash node per section and per value.
+    Sections and values are kept in block arrays, so pointers to them stay valid as the table grows.
+    Small section finds its values by one byte tags kept right in the section, values of bigger
+    sections go to one open addressing index over (section, key) pairs.
+    Values of a section are chained in the order they were added, same as sections.
+*/
+class SectionTable final
+{
+public:
+    using Symbol = SymbolTable::Symbol;
+    using EffectiveValueHash = FlatSymbolMap<const ValueSlot*>;
+
+    // Most sections have fewer values, tags of all of them are compared at once.
+    // Up to this size a tag scan is about twice as fast as the index probe (40 vs 75 ns cold).
+    static constexpr uint32_t small_capacity {12u};
+
+    static_assert(small_capacity <= 16u, "Tags are compared in one vector");
+
+    struct Section final
+    {
+        std::vector<Symbol> inheritances;
+        std::vector<Symbol> attributes;
+
+        // Filled by linking for sections with inheritances only, others just use own values
+        EffectiveValueHash effective_values;
+
+        // Bits of attributes, filled by linking
+        AttributeSet attribute_set;
+
+        const size_t valueCount() const noexcept { return _value_count; }
+
+    private:
+        friend class SectionTable;
+
+        // Same as the table key, values are indexed by it
+        Symbol _symbol {SymbolTable::invalid_symbol};
+        uint32_t _first_value {no_value};
+        uint32_t _last_value {no_value};
+        uint32_t _value_count {0u};
+
+        // Tag and number of every value while section is small
+        std::array<uint8_t, (small_capacity > 8u) ? 16u : 8u> _tags {};
+        std::array<uint32_t, small_capacity> _small_values {};
+    };
+
+private:
+    static constexpr uint32_t no_value {UINT32_MAX};
+
+    struct ValueRecord final
+    {
+        ValueSlot value;
+        Symbol key {SymbolTable::invalid_symbol};
+
+        // Next value of the same section
+        uint32_t next {no_value};
+    };
+
+    struct IndexSlot final
+    {
+        Symbol section {SymbolTable::invalid_symbol};
+        Symbol key {SymbolTable::invalid_symbol};
+        uint32_t value {no_value};
+    };
+
+    using SectionEntry = std::pair<const Symbol, Section>;
+
+    BlockArray<SectionEntry> _sections;
+    BlockArray<ValueRecord> _values;
+
+    FlatSymbolMap<uint32_t> _section_index;
+
+    // Values of big sections only, at most three quarters full
+    std::vector<IndexSlot> _value_index;
+    size_t _indexed_count {0u};
+    uint32_t _value_shift {0u};
+
+public:
+    /**
+        \brief Walks sections in the order they were added as (symbol, section) pairs.
+    */
+    template<typename S, typename E>
+    class SectionIterator final
+    {
+        S* _table;
+        size_t _index;
+
+    public:
+        SectionIterator(S* table, const size_t index) noexcept : _table(table), _index(index) {}
+
+        E& operator*() const noexcept { return _table->_sections[_index]; }
+        E* operator->() const noexcept { return &_table->_sections[_index]; }
+
+        SectionIterator& operator++() noexcept
+        {
+            ++_index;
+            return *this;
+        }
+
+        const bool operator==(const SectionIterator& other) const noexcept { return _index == other._index; }
+        const bool operator!=(const SectionIterator& other) const noexcept { return _index != other._index; }
+    };
+
+    /**
+        \brief Walks values of one section in the order they were added as (key, value) pairs.
+    */
+    template<typename S>
+    class ValueIterator final
+    {
+        S* _table;
+        uint32_t _value;
+
+    public:
+        ValueIterator(S* table, const uint32_t value) noexcept : _table(table), _value(value) {}
+
+        auto operator*() const noexcept
+        {
+            auto& record = _table->_values[_value];
+            return std::pair<Symbol, decltype((record.value))>(record.key, record.value);
+        }
+
+        ValueIterator& operator++() noexcept
+        {
+            _value = _table->_values[_value].next;
+            return *this;
+        }
+
+        const bool operator==(const ValueIterator& other) const noexcept { return _value == other._value; }
+        const bool operator!=(const ValueIterator& other) const noexcept { return _value != other._value; }
+    };
+
+    template<typename S>
+    class ValueRange final
+    {
+        S* _table;
+        const Section& _section;
+
+    public:
+        ValueRange(S* table, const Section& section) noexcept : _table(table), _section(section) {}
+
+        ValueIterator<S> begin() const noexcept { return {_table, _section._first_value}; }
+        ValueIterator<S> end() const noexcept { return {_table, no_value}; }
+
+        const size_t size() const noexcept { return _section._value_count; }
+    };
+
+    SectionTable() noexcept = default;
+
+    SectionTable(SectionTable&&) noexcept = default;
+    SectionTable& operator=(SectionTable&&) noexcept = default;
+
+    SectionTable(SectionTable const&) = delete;
+    SectionTable& operator=(SectionTable const&) = delete;
+
+    /**
+        \brief Adds empty section unless it is already there, returns the section and whether it was added.
+    */
+    std::pair<Section*, bool> try_emplace(const Symbol symbol)
+    {
+        const auto [index, inserted] = _section_index.try_emplace(symbol, static_cast<uint32_t>(_sections.size()));
+
+        if (!inserted)
+            return {&_sections[*index].second, false};
+
+        Section& section = _sections.emplace_back(symbol, Section {}).second;
+        section._symbol = symbol;
+
+        return {&section, true};
+    }
+
+    /**
+        \brief Adds copy of a section of other table (with its values) unless section is already there.
+    */
+    std::pair<Section*, bool> insert(const SectionTable& source, const Symbol symbol, const Section& source_section)
+    {
+        const auto [section, inserted] = this->try_emplace(symbol);
+
+        if (!inserted)
+            return {section, false};
+
+        section->inheritances = source_section.inheritances;
+        section->attributes = source_section.attributes;
+
+        for (const auto& [key, value] : source.values(source_section))
+            *this->emplaceValue(*section, key).first = value;
+
+        return {section, true};
+    }
+
+    Section* find(const Symbol symbol) noexcept
+    {
+        const auto index = _section_index.find(symbol);
+        return (index != nullptr) ? &_sections[*index].second : nullptr;
+    }
+
+    const Section* find(const Symbol symbol) const noexcept
+    {
+        return const_cast<SectionTable&>(*this).find(symbol);
+    }
+
+    /**
+        \brief Adds empty value of the section unless key is already there, returns the value and whether it was added.
+    */
+    std::pair<ValueSlot*, bool> emplaceValue(Section& section, const Symbol key)
+    {
+        if (section._value_count <= small_capacity)
+        {
+            if (const uint32_t value = this->findSmall(section, key); value != no_value)
+                return {&_values[value].value, false};
+
+            if (section._value_count < small_capacity)
+            {
+                section._tags[section._value_count] = tagOf(key);
+                section._small_values[section._value_count] = static_cast<uint32_t>(_values.size());
+
+                return {&this->addValue(section, key), true};
+            }
+
+            // Section outgrows its tags, all its values go to the index
+            this->reserveValues(_indexed_count + section._value_count + 1u);
+
+            for (uint32_t value = section._first_value; value != no_value; value = _values[value].next)
+                _value_index[this->findSlot(section._symbol, _values[value].key)] = {section._symbol, _values[value].key, value};
+
+            _indexed_count += section._value_count;
+        }
+
+        if (((_indexed_count + 1u) * 4u) > (_value_index.size() * 3u))
+            this->reserveValues(_indexed_count + 1u);
+
+        IndexSlot& slot = _value_index[this->findSlot(section._symbol, key)];
+
+        if (slot.value != no_value)
+            return {&_values[slot.value].value, false};
+
+        slot = {section._symbol, key, static_cast<uint32_t>(_values.size())};
+        ++_indexed_count;
+
+        return {&this->addValue(section, key), true};
+    }
+
+    /**
+        \brief Own value of the section, inherited values are in effective values.
+    */
+    ValueSlot* findValue(const Section& section, const Symbol key) noexcept
+    {
+        if (section._value_count <= small_capacity)
+        {
+            const uint32_t value = this->findSmall(section, key);
+            return (value != no_value) ? &_values[value].value : nullptr;
+        }
+
+        const IndexSlot& slot = _value_index[this->findSlot(section._symbol, key)];
+
+        return (slot.value != no_value) ? &_values[slot.value].value : nullptr;
+    }
+
+    const ValueSlot* findValue(const Section& section, const Symbol key) const noexcept
+    {
+        return const_cast<SectionTable&>(*this).findValue(section, key);
+    }
+
+    ValueRange<SectionTable> values(const Section& section) noexcept { return {this, section}; }
+    ValueRange<const SectionTable> values(const Section& section) const noexcept { return {this, section}; }
+
+    /**
+        \brief Makes room for count sections, so adding them does not rehash.
+    */
+    void reserve(const size_t count) { _section_index.reserve(count); }
+
+    const size_t size() const noexcept { return _sections.size(); }
+
+    SectionIterator<SectionTable, SectionEntry> begin() noexcept { return {this, 0u}; }
+    SectionIterator<SectionTable, SectionEntry> end() noexcept { return {this, _sections.size()}; }
+
+    SectionIterator<const SectionTable, const SectionEntry> begin() const noexcept { return {this, 0u}; }
+    SectionIterator<const SectionTable, const SectionEntry> end() const noexcept { return {this, _sections.size()}; }
+
+private:
+    static uint8_t tagOf(const Symbol key) noexcept
+    {
+        // Keys of a section are often neighbour symbols, top bits of the product tell them apart
+        return static_cast<uint8_t>((key * 2654435769u) >> 24u);
+    }
+
+    /**
+        \brief Number of value of small section or no_value.
+    */
+    uint32_t findSmall(const Section& section, const Symbol key) const noexcept
+    {
+        const uint8_t tag = tagOf(key);
+
+#if defined(CFG_SECTION_TABLE_SSE2)
+        __m128i tags;
+
+        if constexpr (small_capacity > 8u)
+            tags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(section._tags.data()));
+        else
+            tags = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(section._tags.data()));
+
+        uint32_t matches = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+        uint32_t matches = 0u;
+
+        for (uint32_t index = 0u; index < small_capacity; ++index)
+            matches |= static_cast<uint32_t>(section._tags[index] == tag) << index;
+#endif
+
+        // Tags past the count are zero and may match too
+        matches &= (1u << section._value_count) - 1u;
+
+        for (; matches != 0u; matches &= matches - 1u)
+        {
+            const uint32_t value = section._small_values[std::countr_zero(matches)];
+
+            if (_values[value].key == key)
+                return value;
+        }
+
+        return no_value;
+    }
+
+    /**
+        \brief Appends value to the chain of the section.
+    */
+    ValueSlot& addValue(Section& section, const Symbol key)
+    {
+        const uint32_t value = static_cast<uint32_t>(_values.size());
+        ValueRecord& record = _values.emplace_back();
+        record.key = key;
+
+        if (section._last_value != no_value)
+            _values[section._last_value].next = value;
+        else
+            section._first_value = value;
+
+        section._last_value = value;
+        ++section._value_count;
+
+        return record.value;
+    }
+
+    /**
+        \brief Slot which holds the pair or empty slot where it should go.
+    */
+    size_t findSlot(const Symbol section, const Symbol key) const noexcept
+    {
+        const size_t mask = _value_index.size() - 1u;
+        const uint64_t pair = (static_cast<uint64_t>(section) << 32u) | key;
+        size_t index = static_cast<size_t>((pair * 11400714819323198485ull) >> _value_shift);
+
+        while ((_value_index[index].value != no_value) &&
+            ((_value_index[index].section != section) || (_value_index[index].key != key)))
+            index = (index + 1u) & mask;
+
+        return index;
+    }
+
+    void reserveValues(const size_t count)
+    {
+        size_t capacity = 16u;
+        uint32_t shift = 60u;
+
+        while ((capacity * 3u) < (count * 4u))
+        {
+            capacity *= 2u;
+            --shift;
+        }
+
+        if (capacity <= _value_index.size())
+            return;
+
+        std::vector<IndexSlot> slots(capacity);
+        std::swap(slots, _value_index);
+        _value_shift = shift;
+
+        for (const auto& slot : slots)
+        {
+            if (slot.value != no_value)
+                _value_index[this->findSlot(slot.section, slot.key)] = slot;
+        }
+    }
+};
+
+#endif
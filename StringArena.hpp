@@ -0,0 +1,116 @@
+#ifndef _STRING_ARENA_HPP_
+#define _STRING_ARENA_HPP_
+
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+
+
+/**
+    \brief Append-only storage for strings.
+    Strings are packed one after another into big blocks, views returned by
+    store() stay valid until the arena is cleared or destroyed.
+*/
+class StringArena final
+{
+    static constexpr size_t block_size {64u * 1024u};
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    std::vector<std::unique_ptr<char[]>> _large;
+
+    char* _position {nullptr};
+    size_t _available {0u};
+
+public:
+    StringArena() noexcept = default;
+
+    StringArena(StringArena&&) noexcept = default;
+    StringArena& operator=(StringArena&&) noexcept = default;
+
+    StringArena(StringArena const&) = delete;
+    StringArena& operator=(StringArena const&) = delete;
+
+    /**
+        \brief Copies string into arena and returns view of the copy.
+    */
+    inline std::string_view store(const std::string_view string)
+    {
+        if (string.empty())
+            return {};
+
+        // Big strings get own allocation so the current block keeps being filled
+        if (string.size() > (block_size / 4u))
+        {
+            char* const result = _large.emplace_back(new char[string.size()]).get();
+            std::memcpy(result, string.data(), string.size());
+
+            return std::string_view(result, string.size());
+        }
+
+        if (string.size() > _available)
+        {
+            _position = _blocks.emplace_back(new char[block_size]).get();
+            _available = block_size;
+        }
+
+        char* const result = _position;
+        std::memcpy(result, string.data(), string.size());
+
+        _position += string.size();
+        _available -= string.size();
+
+        return std::string_view(result, string.size());
+    }
+
+    /**
+        \brief Uninitialized storage for other data (alignment up to 16), lives as long as strings do.
+    */
+    inline void* allocate(const size_t size, const size_t alignment)
+    {
+        if (size > (block_size / 4u))
+            return _large.emplace_back(new char[size]).get();
+
+        const size_t padding = static_cast<size_t>(-reinterpret_cast<uintptr_t>(_position)) & (alignment - 1u);
+
+        if ((size + padding) > _available)
+        {
+            _position = _blocks.emplace_back(new char[block_size]).get();
+            _available = block_size;
+
+            return this->allocate(size, alignment);
+        }
+
+        char* const result = _position + padding;
+
+        _position += size + padding;
+        _available -= size + padding;
+
+        return result;
+    }
+
+    /**
+        \brief Takes over all strings of other arena.
+    */
+    void absorb(StringArena&& other)
+    {
+        for (auto& block : other._blocks)
+            _blocks.push_back(std::move(block));
+
+        for (auto& block : other._large)
+            _large.push_back(std::move(block));
+
+        other.clear();
+    }
+
+    void clear() noexcept
+    {
+        _blocks.clear();
+        _large.clear();
+        _position = nullptr;
+        _available = 0u;
+    }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef _STRUCTURAL_SCANNER_HPP_
+#define _STRUCTURAL_SCANNER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define CFG_SCANNER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CFG_SCANNER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+
+/**
+    \brief Finds bytes which have a meaning for the config grammar.
+    Input is classified in 64-byte blocks, one bit per byte, so the parser
+    can take everything between two structural bytes as a single literal run.
+    Structural bytes are: [ ] : = , ; | " \ # < > space, tab, CR and LF.
+*/
+class StructuralScanner final
+{
+public:
+    static constexpr size_t block_size {64u};
+
+    static constexpr std::array<char, 16u> structural_characters
+    {
+        '[', ']', ':', '=', ',', ';', '|', '\"', '\\', '#', '<', '>', ' ', '\t', '\r', '\n'
+    };
+
+private:
+    /**
+        \brief Nibble tables: byte is structural if (low[c & 0xF] & high[c >> 4]) != 0.
+        Every distinct high nibble of the set gets its own bit.
+    */
+    struct NibbleTables final
+    {
+        std::array<uint8_t, 16u> low {};
+        std::array<uint8_t, 16u> high {};
+    };
+
+    static constexpr NibbleTables makeNibbleTables()
+    {
+        NibbleTables tables {};
+        uint8_t next_bit = 1u;
+
+        for (const auto character : structural_characters)
+        {
+            const uint8_t byte = static_cast<uint8_t>(character);
+
+            if (tables.high[byte >> 4u] == 0u)
+            {
+                tables.high[byte >> 4u] = next_bit;
+                next_bit = static_cast<uint8_t>(next_bit << 1u);
+            }
+
+            tables.low[byte & 0x0Fu] |= tables.high[byte >> 4u];
+        }
+
+        return tables;
+    }
+
+    static constexpr std::array<bool, 256u> makeLookupTable()
+    {
+        std::array<bool, 256u> table {};
+
+        for (const auto character : structural_characters)
+            table[static_cast<uint8_t>(character)] = true;
+
+        return table;
+    }
+
+    static constexpr bool checkNibbleTables()
+    {
+        const auto nibbles = makeNibbleTables();
+        const auto lookup = makeLookupTable();
+
+        for (uint32_t byte = 0u; byte < 256u; ++byte)
+        {
+            const bool nibble = (nibbles.low[byte & 0x0Fu] & nibbles.high[byte >> 4u]) != 0u;
+
+            if (nibble != lookup[byte])
+                return false;
+        }
+
+        return true;
+    }
+
+    static const NibbleTables nibble_tables;
+    static const std::array<bool, 256u> lookup_table;
+
+    const char* const _begin;
+    const char* const _end;
+
+    // Currently classified block
+    const char* _block {nullptr};
+    uint64_t _mask {0u};
+
+public:
+    StructuralScanner(const char* const begin, const char* const end) noexcept :
+        _begin(begin), _end(end) {}
+
+    static inline bool isStructural(const char character) noexcept
+    {
+        return lookup_table[static_cast<uint8_t>(character)];
+    }
+
+    /**
+        \brief Returns first structural byte at or after position, or end of input.
+    */
+    inline const char* next(const char* position) noexcept
+    {
+        while (position < _end)
+        {
+            const char* const block = _begin + ((position - _begin) & ~static_cast<ptrdiff_t>(block_size - 1u));
+
+            if (block != _block)
+            {
+                _block = block;
+                _mask = this->classify(block);
+            }
+
+            const uint64_t mask = _mask >> static_cast<uint32_t>(position - block);
+
+            if (mask != 0u)
+                return position + countTrailingZeros(mask);
+
+            position = block + block_size;
+        }
+
+        return _end;
+    }
+
+    /**
+        \brief One bit per structural byte of a full 64-byte block.
+    */
+    static inline uint64_t classifyBlock(const char* const block) noexcept
+    {
+        static_assert(checkNibbleTables(), "Structural character set is not separable by nibbles");
+
+#if defined(CFG_SCANNER_AVX2)
+        const __m256i low_table = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble_tables.low.data())));
+        const __m256i high_table = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble_tables.high.data())));
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+        const __m256i zero = _mm256_setzero_si256();
+
+        const auto classify32 = [&](const __m256i bytes) -> uint32_t
+        {
+            const __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(bytes, nibble_mask));
+            const __m256i high = _mm256_shuffle_epi8(high_table,
+                _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble_mask));
+
+            return ~static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero)));
+        };
+
+        const uint64_t lo = classify32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)));
+        const uint64_t hi = classify32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32)));
+
+        return lo | (hi << 32u);
+#elif defined(CFG_SCANNER_SSE2)
+        const auto classify16 = [](const __m128i bytes) -> uint64_t
+        {
+            __m128i result = _mm_setzero_si128();
+
+            for (const auto character : structural_characters)
+                result = _mm_or_si128(result, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(character)));
+
+            return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(result)));
+        };
+
+        uint64_t mask = 0u;
+
+        for (uint32_t offset = 0u; offset < block_size; offset += 16u)
+            mask |= classify16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset))) << offset;
+
+        return mask;
+#else
+        uint64_t mask = 0u;
+
+        for (uint32_t offset = 0u; offset < block_size; ++offset)
+            mask |= static_cast<uint64_t>(isStructural(block[offset])) << offset;
+
+        return mask;
+#endif
+    }
+
+private:
+    inline uint64_t classify(const char* const block) const noexcept
+    {
+        if (static_cast<size_t>(_end - block) >= block_size)
+            return classifyBlock(block);
+
+        // Tail block: pad with a non-structural byte, never read past the input
+        std::array<char, block_size> padded;
+        padded.fill('a');
+        std::memcpy(padded.data(), block, static_cast<size_t>(_end - block));
+
+        return classifyBlock(padded.data());
+    }
+
+    static inline uint32_t countTrailingZeros(const uint64_t value) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0u;
+        _BitScanForward64(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+};
+
+inline constexpr StructuralScanner::NibbleTables StructuralScanner::nibble_tables {StructuralScanner::makeNibbleTables()};
+inline constexpr std::array<bool, 256u> StructuralScanner::lookup_table {StructuralScanner::makeLookupTable()};
+
+#endif
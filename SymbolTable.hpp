@@ -0,0 +1,131 @@
+#ifndef _SYMBOL_TABLE_HPP_
+#define _SYMBOL_TABLE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "StringArena.hpp"
+
+
+/**
+    \brief Interning pool. Every distinct name is stored once and gets a dense integer id,
+    so names are compared and hashed as integers once they are interned.
+    Lookup table is open addressing with the name kept in the slot,
+    so finding a name touches one slot and the name itself.
+*/
+class SymbolTable final
+{
+public:
+    using Symbol = uint32_t;
+
+    static constexpr Symbol invalid_symbol {UINT32_MAX};
+
+private:
+    struct Slot final
+    {
+        std::string_view name;
+        uint32_t hash {0u};
+        Symbol symbol {invalid_symbol};
+    };
+
+    StringArena _strings;
+
+    std::vector<Slot> _slots;
+    std::vector<std::string_view> _names;
+
+public:
+    SymbolTable() noexcept = default;
+
+    SymbolTable(SymbolTable const&) = delete;
+    SymbolTable& operator=(SymbolTable const&) = delete;
+
+    /**
+        \brief Returns symbol of the name, new names are copied into the table.
+    */
+    inline Symbol intern(const std::string_view name)
+    {
+        // At most half full
+        if ((_names.size() + 1u) * 2u > _slots.size())
+            this->grow();
+
+        const uint32_t hash = hashName(name);
+        Slot& slot = _slots[this->findSlot(name, hash)];
+
+        if (slot.symbol != invalid_symbol)
+            return slot.symbol;
+
+        slot.name = _strings.store(name);
+        slot.hash = hash;
+        slot.symbol = static_cast<Symbol>(_names.size());
+
+        _names.push_back(slot.name);
+
+        return slot.symbol;
+    }
+
+    /**
+        \brief Returns symbol of the name or invalid_symbol if name was never interned.
+    */
+    inline Symbol find(const std::string_view name) const noexcept
+    {
+        if (_slots.empty())
+            return invalid_symbol;
+
+        return _slots[this->findSlot(name, hashName(name))].symbol;
+    }
+
+    inline std::string_view name(const Symbol symbol) const noexcept
+    {
+        return (symbol < _names.size()) ? _names[symbol] : std::string_view {};
+    }
+
+    inline size_t size() const noexcept { return _names.size(); }
+
+private:
+    static inline uint32_t hashName(const std::string_view name) noexcept
+    {
+        const size_t hash = std::hash<std::string_view>{}(name);
+        return static_cast<uint32_t>(hash ^ (hash >> 32u));
+    }
+
+    /**
+        \brief Slot which holds the name or empty slot where it should go.
+    */
+    inline size_t findSlot(const std::string_view name, const uint32_t hash) const noexcept
+    {
+        const size_t mask = _slots.size() - 1u;
+
+        for (size_t index = hash & mask;; index = (index + 1u) & mask)
+        {
+            const Slot& slot = _slots[index];
+
+            if ((slot.symbol == invalid_symbol) || ((slot.hash == hash) && (slot.name == name)))
+                return index;
+        }
+    }
+
+    void grow()
+    {
+        std::vector<Slot> slots(_slots.empty() ? 64u : (_slots.size() * 2u));
+        const size_t mask = slots.size() - 1u;
+
+        for (const auto& slot : _slots)
+        {
+            if (slot.symbol == invalid_symbol)
+                continue;
+
+            size_t index = slot.hash & mask;
+
+            while (slots[index].symbol != invalid_symbol)
+                index = (index + 1u) & mask;
+
+            slots[index] = slot;
+        }
+
+        _slots = std::move(slots);
+    }
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef _VALUE_CONVERSION_HPP_
+#define _VALUE_CONVERSION_HPP_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "NumberParser.hpp"
+
+
+enum class ConversionError : uint8_t
+{
+    NONE,
+    MISSING,
+    INVALID,
+    OUT_OF_RANGE
+};
+
+/**
+    \brief Typed value or the reason why there is none, value is zero on failure.
+*/
+template<typename T>
+struct Conversion final
+{
+    T value {};
+    ConversionError error {ConversionError::NONE};
+
+    explicit operator bool() const noexcept { return error == ConversionError::NONE; }
+};
+
+/**
+    \brief Converts number in the characters, as std::from_chars, but also takes leading '+'.
+    Returns end of the number, value is left untouched on failure.
+    Plain decimal numbers take NumberParser's fast path with the same results.
+*/
+template<typename T>
+inline const char* convertNumber(const char* begin, const char* const end, T& value, ConversionError& error) noexcept
+{
+    if constexpr (NumberParser::isSupported<T>())
+    {
+        if (const char* const number_end = NumberParser::parse(begin, end, value); number_end != nullptr)
+        {
+            error = ConversionError::NONE;
+            return number_end;
+        }
+    }
+
+    if ((begin != end) && (*begin == '+') && ((begin + 1) != end) && (begin[1] != '-') && (begin[1] != '+'))
+        ++begin;
+
+    std::from_chars_result result;
+
+    if constexpr (std::is_floating_point<T>::value)
+        result = std::from_chars(begin, end, value, std::chars_format::general);
+    else
+        result = std::from_chars(begin, end, value, 10);
+
+    if (result.ec == std::errc::invalid_argument)
+        error = ConversionError::INVALID;
+    else if (result.ec == std::errc::result_out_of_range)
+        error = ConversionError::OUT_OF_RANGE;
+    else
+        error = ConversionError::NONE;
+
+    return result.ptr;
+}
+
+/**
+    \brief Converts whole value text, never throws and does not depend on locale.
+    Bool is true for "true", "on" and "yes" and false for anything else,
+    enums are converted as their underlying type.
+*/
+template<typename T>
+inline Conversion<T> convertValue(const std::string_view text) noexcept
+{
+    Conversion<T> result;
+
+    if constexpr (std::is_same<T, bool>::value)
+    {
+        result.value = (text == "true") || (text == "on") || (text == "yes");
+    }
+    else if constexpr (std::is_enum<T>::value)
+    {
+        const auto underlying = convertValue<std::underlying_type_t<T>>(text);
+
+        result.value = static_cast<T>(underlying.value);
+        result.error = underlying.error;
+    }
+    else
+    {
+        static_assert(std::is_arithmetic<T>::value, "Value can be converted to number, bool or enum only");
+
+        const char* const end = text.data() + text.size();
+        const char* const number_end = convertNumber(text.data(), end, result.value, result.error);
+
+        // Number followed by anything else is not a number
+        if ((result.error == ConversionError::NONE) && (number_end != end))
+            result.error = ConversionError::INVALID;
+
+        if (result.error != ConversionError::NONE)
+            result.value = static_cast<T>(0);
+    }
+
+    return result;
+}
+
+/**
+    \brief Result of array conversion into caller's storage.
+    Count is number of elements written, overflow means value has more elements than fit.
+*/
+struct ArrayConversion final
+{
+    size_t count {0u};
+    bool overflow {false};
+
+    // First element which could not be converted (it is written as zero)
+    ConversionError error {ConversionError::NONE};
+};
+
+/**
+    \brief Converts comma separated elements right over the text, nothing is allocated.
+    Elements past capacity are counted as overflow but not converted.
+*/
+template<typename T>
+inline ArrayConversion convertArray(const std::string_view text, T* const output, const size_t capacity) noexcept
+{
+    ArrayConversion result;
+
+    if (text.empty())
+        return result;
+
+    const char* const end = text.data() + text.size();
+
+    NumberParser::split(text.data(), end, [&result, output, capacity, end](const char* const begin, const char* const element_end)
+    {
+        if (result.count == capacity)
+        {
+            result.overflow = true;
+            return false;
+        }
+
+        Conversion<T> element;
+
+        if constexpr (NumberParser::isSupported<T>())
+        {
+            // Whole text may be read, element is parsed a block at a time
+            if (NumberParser::parse(begin, element_end, end, element.value) != element_end)
+                element = convertValue<T>(std::string_view(begin, static_cast<size_t>(element_end - begin)));
+        }
+        else
+        {
+            element = convertValue<T>(std::string_view(begin, static_cast<size_t>(element_end - begin)));
+        }
+
+        if ((element.error != ConversionError::NONE) && (result.error == ConversionError::NONE))
+            result.error = element.error;
+
+        output[result.count++] = element.value;
+
+        return true;
+    });
+
+    return result;
+}
+
+/**
+    \brief Number of comma separated elements in the text.
+*/
+inline size_t countArrayElements(const std::string_view text) noexcept
+{
+    return text.empty() ? 0u : (static_cast<size_t>(std::count(text.begin(), text.end(), ',')) + 1u);
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef _VALUE_SLOT_HPP_
+#define _VALUE_SLOT_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+
+/**
+    \brief Value text together with its last typed conversion.
+    Conversion is written by a const typed read, so it is guarded by a sequence counter:
+    readers never block, a reader which races with a writer just misses the cache.
+    Assigning new text drops the conversion.
+*/
+class ValueSlot final
+{
+    std::string_view _text;
+
+    // Type id of typed array entry
+    static constexpr uint32_t array_type {0x100u};
+
+    // Odd while conversion is being written
+    mutable std::atomic<uint32_t> _sequence {0u};
+    mutable std::atomic<uint32_t> _cached_type {0u};
+    mutable std::atomic<uint64_t> _cached_bits {0u};
+
+public:
+    ValueSlot() noexcept = default;
+    ValueSlot(std::string_view text) noexcept : _text(text) {}
+
+    // Copy is just the text, conversion is made again when needed
+    ValueSlot(const ValueSlot& other) noexcept : _text(other._text) {}
+
+    ValueSlot& operator=(const ValueSlot& other) noexcept { return (*this = other._text); }
+
+    ValueSlot& operator=(std::string_view text) noexcept
+    {
+        _text = text;
+        _cached_type.store(0u, std::memory_order_relaxed);
+
+        return *this;
+    }
+
+    std::string_view view() const noexcept { return _text; }
+    operator std::string_view() const noexcept { return _text; }
+
+    const bool empty() const noexcept { return _text.empty(); }
+
+    /**
+        \brief Conversions of these types are cached, type id 0 means not cached.
+    */
+    template<typename T>
+    static constexpr uint32_t typeId() noexcept
+    {
+        if constexpr (std::is_same<T, bool>::value)
+            return 1u;
+        else if constexpr (std::is_same<T, int>::value)
+            return 2u;
+        else if constexpr (std::is_same<T, uint32_t>::value)
+            return 3u;
+        else if constexpr (std::is_same<T, float>::value)
+            return 4u;
+        else if constexpr (std::is_same<T, double>::value)
+            return 5u;
+        else if constexpr (std::is_same<T, int64_t>::value)
+            return 6u;
+        else if constexpr (std::is_same<T, uint64_t>::value)
+            return 7u;
+        else if constexpr (std::is_same<T, int8_t>::value)
+            return 8u;
+        else if constexpr (std::is_same<T, int16_t>::value)
+            return 9u;
+        else if constexpr (std::is_same<T, uint16_t>::value)
+            return 10u;
+        // Same type as one of above on most platforms
+        else if constexpr (std::is_same<T, size_t>::value)
+            return 11u;
+        else
+            return 0u;
+    }
+
+    template<typename T>
+    const bool getCached(T& value) const noexcept
+    {
+        static_assert((typeId<T>() == 0u) || (sizeof(T) <= sizeof(uint64_t)), "Cached type does not fit");
+
+        if constexpr (typeId<T>() == 0u)
+        {
+            return false;
+        }
+        else
+        {
+            uint64_t bits = 0u;
+
+            if (!this->loadCache(typeId<T>(), bits))
+                return false;
+
+            std::memcpy(&value, &bits, sizeof(T));
+
+            return true;
+        }
+    }
+
+    template<typename T>
+    void setCached(const T value) const noexcept
+    {
+        if constexpr (typeId<T>() != 0u)
+        {
+            uint64_t bits = 0u;
+            std::memcpy(&bits, &value, sizeof(T));
+
+            this->storeCache(typeId<T>(), bits);
+        }
+    }
+
+    /**
+        \brief Typed array made at load time, kept in place of the typed conversion:
+        text of an array never converts to a single number, so the two never meet.
+        Blob is the element count followed by the elements.
+    */
+    template<typename T>
+    void setArray(const uint64_t* const blob) noexcept
+    {
+        static_assert(typeId<T>() != 0u, "Array type is not cached");
+
+        this->storeCache(array_type | typeId<T>(), static_cast<uint64_t>(reinterpret_cast<uintptr_t>(blob)));
+    }
+
+    template<typename T>
+    const bool getArray(std::span<const T>& elements) const noexcept
+    {
+        if constexpr (typeId<T>() == 0u)
+        {
+            return false;
+        }
+        else
+        {
+            uint64_t bits = 0u;
+
+            if (!this->loadCache(array_type | typeId<T>(), bits))
+                return false;
+
+            const uint64_t* const blob = reinterpret_cast<const uint64_t*>(static_cast<uintptr_t>(bits));
+            elements = std::span<const T>(reinterpret_cast<const T*>(blob + 1), static_cast<size_t>(blob[0]));
+
+            return true;
+        }
+    }
+
+    const bool hasArray() const noexcept { return (_cached_type.load(std::memory_order_relaxed) & array_type) != 0u; }
+
+private:
+    const bool loadCache(const uint32_t type, uint64_t& bits) const noexcept
+    {
+        const uint32_t sequence = _sequence.load(std::memory_order_acquire);
+
+        if ((sequence & 1u) != 0u)
+            return false;
+
+        // Acquire keeps the second sequence load after these ones
+        const uint32_t cached_type = _cached_type.load(std::memory_order_acquire);
+        bits = _cached_bits.load(std::memory_order_acquire);
+
+        return (cached_type == type) && (_sequence.load(std::memory_order_relaxed) == sequence);
+    }
+
+    void storeCache(const uint32_t type, const uint64_t bits) const noexcept
+    {
+        uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+
+        // Somebody else is writing, this conversion is just not cached
+        if (((sequence & 1u) != 0u) ||
+            !_sequence.compare_exchange_strong(sequence, sequence + 1u, std::memory_order_relaxed))
+            return;
+
+        // Reader which sees any of these sees the odd sequence too
+        _cached_type.store(type, std::memory_order_release);
+        _cached_bits.store(bits, std::memory_order_release);
+
+        _sequence.store(sequence + 2u, std::memory_order_release);
+    }
+};
+
+#endif